@@ -0,0 +1,139 @@
+#include <binsparse/binsparse.hpp>
+#include <chrono>
+#include <cstring>
+#include <fmt/core.h>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+// Load the matrix in `file_name`, returning the number of stored values.
+std::size_t load_matrix(const std::string& file_name) {
+  using T = double;
+  using I = std::uint64_t;
+
+  auto metadata = binsparse::inspect(file_name)["binsparse"];
+  std::string format = metadata["format"];
+
+  std::allocator<T> t_alloc;
+  std::allocator<I> i_alloc;
+
+  std::size_t nnz = 0;
+  if (format == "CSR") {
+    auto m = binsparse::read_csr_matrix<T, I>(file_name);
+    nnz = m.nnz;
+    t_alloc.deallocate(m.values, m.nnz);
+    i_alloc.deallocate(m.colind, m.nnz);
+    i_alloc.deallocate(m.row_ptr, m.m + 1);
+  } else if (format == "CSC") {
+    auto m = binsparse::read_csc_matrix<T, I>(file_name);
+    nnz = m.nnz;
+    t_alloc.deallocate(m.values, m.nnz);
+    i_alloc.deallocate(m.rowind, m.nnz);
+    i_alloc.deallocate(m.col_ptr, m.n + 1);
+  } else if (format == "COO" || format == "COOR") {
+    auto m = binsparse::read_coo_matrix<T, I>(file_name);
+    nnz = m.nnz;
+    t_alloc.deallocate(m.values, m.nnz);
+    i_alloc.deallocate(m.rowind, m.nnz);
+    i_alloc.deallocate(m.colind, m.nnz);
+  } else {
+    throw std::runtime_error("unsupported format " + format);
+  }
+  return nnz;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::cout << "usage: ./concurrent_read [matrix.bsp.hdf5] [num_processes] "
+                 "[--no-file-locking]\n";
+    return 1;
+  }
+
+  std::string file_name(argv[1]);
+  std::size_t num_processes = argc > 2 ? std::stoull(argv[2]) : 8;
+  bool file_locking =
+      !(argc > 3 && std::strcmp(argv[3], "--no-file-locking") == 0);
+
+  binsparse::set_file_locking(file_locking);
+
+  // Children block on `start` until every process has been forked, then
+  // report their load time in microseconds through `results`.
+  int start[2];
+  int results[2];
+  if (pipe(start) != 0 || pipe(results) != 0) {
+    std::cerr << "failed to create pipes\n";
+    return 1;
+  }
+
+  std::vector<pid_t> children;
+  for (std::size_t p = 0; p < num_processes; p++) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      close(start[1]);
+      close(results[0]);
+      char c;
+      if (read(start[0], &c, 1) < 0) {
+        _exit(1);
+      }
+
+      auto begin = std::chrono::steady_clock::now();
+      load_matrix(file_name);
+      auto end = std::chrono::steady_clock::now();
+
+      long long us =
+          std::chrono::duration_cast<std::chrono::microseconds>(end - begin)
+              .count();
+      if (write(results[1], &us, sizeof(us)) != sizeof(us)) {
+        _exit(1);
+      }
+      _exit(0);
+    }
+    children.push_back(pid);
+  }
+
+  close(start[0]);
+  close(results[1]);
+
+  auto begin = std::chrono::steady_clock::now();
+  close(start[1]);
+
+  std::vector<double> times;
+  long long us;
+  while (read(results[0], &us, sizeof(us)) == sizeof(us)) {
+    times.push_back(us / 1e6);
+  }
+
+  int failures = 0;
+  for (auto&& pid : children) {
+    int status;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      failures++;
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  if (failures > 0 || times.empty()) {
+    fmt::print("{} of {} readers failed\n", failures, num_processes);
+    return 1;
+  }
+
+  double total = 0;
+  for (auto&& t : times) {
+    total += t;
+  }
+
+  fmt::print("{} concurrent readers, file locking {}\n", num_processes,
+             file_locking ? "on" : "off");
+  fmt::print("per-process load: min {:.3f} s, mean {:.3f} s, max {:.3f} s\n",
+             *std::min_element(times.begin(), times.end()),
+             total / times.size(),
+             *std::max_element(times.begin(), times.end()));
+  fmt::print("wall time for all readers: {:.3f} s\n",
+             std::chrono::duration<double>(end - begin).count());
+
+  return 0;
+}
@@ -1,4 +1,5 @@
 #include <binsparse/binsparse.hpp>
+#include <binsparse/matrix_market/matrix_market_convert.hpp>
 #include <complex>
 #include <concepts>
 #include <iostream>
@@ -6,7 +7,8 @@
 template <typename T, typename I>
 void convert_to_binsparse(std::string input_file, std::string output_file,
                           std::string format, std::string comment,
-                          std::optional<std::string> group = {}) {
+                          std::optional<std::string> group = {},
+                          std::optional<std::size_t> memory_budget = {}) {
   H5::H5File file;
   std::unique_ptr<H5::Group> f_p;
 
@@ -23,7 +25,13 @@ void convert_to_binsparse(std::string input_file, std::string output_file,
 
   nlohmann::json user_keys;
   user_keys["comment"] = comment;
-  if (format == "CSR") {
+  if (memory_budget.has_value()) {
+    std::cout << "Writing to binsparse file " << output_file << " using "
+              << format << " format with a memory budget of "
+              << memory_budget.value() << " bytes...\n";
+    binsparse::convert_matrix_market<T, I>(input_file, f, format,
+                                           memory_budget.value(), user_keys);
+  } else if (format == "CSR") {
     auto x = binsparse::__detail::mmread<
         T, I, binsparse::__detail::csr_matrix_owning<T, I>>(input_file);
     binsparse::csr_matrix<T, I> matrix{
@@ -50,20 +58,21 @@ template <typename I>
 void convert_to_binsparse(std::string input_file, std::string output_file,
                           std::string type, std::string format,
                           std::string comment,
-                          std::optional<std::string> group = {}) {
+                          std::optional<std::string> group = {},
+                          std::optional<std::size_t> memory_budget = {}) {
   if (type == "real") {
     convert_to_binsparse<float, I>(input_file, output_file, format, comment,
-                                   group);
+                                   group, memory_budget);
   } else if (type == "complex") {
     assert(false);
     // convert_to_binsparse<std::complex<float>, I>(input_file, output_file,
     // format, comment);
   } else if (type == "integer") {
     convert_to_binsparse<int64_t, I>(input_file, output_file, format, comment,
-                                     group);
+                                     group, memory_budget);
   } else if (type == "pattern") {
     convert_to_binsparse<uint8_t, I>(input_file, output_file, format, comment,
-                                     group);
+                                     group, memory_budget);
   }
 }
 
@@ -110,23 +119,54 @@ inline void convert_to_binsparse_vector(std::string input_file,
   }
 }
 
+// Parse a size in bytes with an optional K, M or G suffix, e.g. "512M".
+inline std::size_t parse_memory_size(std::string size) {
+  std::size_t pos;
+  std::size_t value = std::stoull(size, &pos);
+  std::string suffix = size.substr(pos);
+
+  if (suffix == "" || suffix == "B") {
+    return value;
+  } else if (suffix == "K" || suffix == "k") {
+    return value << 10;
+  } else if (suffix == "M" || suffix == "m") {
+    return value << 20;
+  } else if (suffix == "G" || suffix == "g") {
+    return value << 30;
+  } else {
+    throw std::runtime_error("Invalid memory size \"" + size + "\"");
+  }
+}
+
 int main(int argc, char** argv) {
+  std::vector<std::string> args;
+  std::optional<std::size_t> memory_budget;
+
+  std::string memory_flag = "--memory-budget=";
+  for (int i = 1; i < argc; i++) {
+    std::string arg(argv[i]);
+    if (arg.starts_with(memory_flag)) {
+      memory_budget = parse_memory_size(arg.substr(memory_flag.size()));
+    } else {
+      args.push_back(arg);
+    }
+  }
 
-  if (argc < 3) {
+  if (args.size() < 2) {
     std::cout << "usage: ./convert_binsparse [input_file.mtx] "
                  "[output_file.hdf5] [optional: format {CSR, COO}] [optional: "
-                 "HDF5 group name]\n";
+                 "HDF5 group name] [optional: --memory-budget=SIZE]\n";
     return 1;
   }
 
-  std::string input_file(argv[1]);
-  std::string output_file(argv[2]);
+  std::string input_file(args[0]);
+  std::string output_file(args[1]);
 
   std::string format;
   std::optional<std::string> group;
 
-  if (argc >= 4) {
-    format = argv[3];
+  if (args.size() >= 3) {
+    format = args[2];
 
     for (auto&& c : format) {
       c = std::toupper(c);
@@ -135,8 +175,8 @@ int main(int argc, char** argv) {
     format = "COO";
   }
 
-  if (argc >= 5) {
-    group = argv[4];
+  if (args.size() >= 4) {
+    group = args[3];
   }
 
   auto [m, n, nnz, mm_format, type, structure, comment] =
@@ -154,16 +194,16 @@ int main(int argc, char** argv) {
 
     if (max_size + 1 <= std::numeric_limits<uint8_t>::max()) {
       convert_to_binsparse<uint8_t>(input_file, output_file, type, format,
-                                    comment, group);
+                                    comment, group, memory_budget);
     } else if (max_size + 1 <= std::numeric_limits<uint16_t>::max()) {
       convert_to_binsparse<uint16_t>(input_file, output_file, type, format,
-                                     comment, group);
+                                     comment, group, memory_budget);
     } else if (max_size + 1 <= std::numeric_limits<uint32_t>::max()) {
       convert_to_binsparse<uint32_t>(input_file, output_file, type, format,
-                                     comment, group);
+                                     comment, group, memory_budget);
     } else if (max_size + 1 <= std::numeric_limits<uint64_t>::max()) {
       convert_to_binsparse<uint64_t>(input_file, output_file, type, format,
-                                     comment, group);
+                                     comment, group, memory_budget);
     } else {
       throw std::runtime_error(
           "Error! Matrix dimensions or NNZ too large to handle.");
@@ -1,3 +1,4 @@
+#include <binsparse/any_matrix.hpp>
 #include <binsparse/binsparse.hpp>
 #include <complex>
 #include <concepts>
@@ -21,43 +22,22 @@ int main(int argc, char** argv) {
             << metadata["shape"] << " with " << metadata["nnz"]
             << " nonzeros\n";
 
-  if (metadata["format"] == "COO") {
-    auto i0 = metadata["data_types"]["indices_0"];
-    auto i1 = metadata["data_types"]["indices_1"];
-    auto t = metadata["data_types"]["values"];
-
-    binsparse::visit_label(
-        {i0, i1, t},
-        [&]<typename I1, typename I2, typename T>(I1 i, I2 j, T v) {
-          using I = std::conditional_t<std::numeric_limits<I1>::max() <
-                                           std::numeric_limits<I2>::max(),
-                                       I2, I1>;
-          std::cout << "Reading binsparse with index and value types: "
-                    << binsparse::type_info<I>::label() << " "
-                    << binsparse::type_info<T>::label() << "\n";
-
-          auto m = binsparse::read_coo_matrix<T, I>(input_file);
-        });
-  } else if (metadata["format"] == "CSR") {
-    auto i0 = metadata["data_types"]["pointers_to_1"];
-    auto i1 = metadata["data_types"]["indices_1"];
-    auto t = metadata["data_types"]["values"];
-
-    binsparse::visit_label(
-        {i0, i1, t},
-        [&]<typename I1, typename I2, typename T>(I1 i, I2 j, T v) {
-          using I = std::conditional_t<std::numeric_limits<I1>::max() <
-                                           std::numeric_limits<I2>::max(),
-                                       I2, I1>;
-          std::cout << "Reading binsparse with index and value types: "
-                    << binsparse::type_info<I>::label() << " "
-                    << binsparse::type_info<T>::label() << "\n";
-
-          auto m = binsparse::read_csr_matrix<T, I>(input_file);
-        });
-  } else {
-    assert(false);
-  }
+  // The format and types are only known once the file is read, so the typed
+  // matrix is handled in a generic lambda.
+  auto matrix = binsparse::read_matrix(input_file);
+
+  auto print_type = []<typename T>(T*) {
+    std::cout << "Read binsparse with value type: "
+              << binsparse::type_info<T>::label() << "\n";
+  };
+
+  matrix.visit([&](auto&& m) {
+    if constexpr (requires { m.values; }) {
+      print_type(m.values);
+    } else {
+      print_type(m.data());
+    }
+  });
 
   return 0;
 }
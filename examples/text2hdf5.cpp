@@ -1,6 +1,7 @@
 #include <binsparse/binsparse.hpp>
 #include <complex>
 #include <concepts>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 
@@ -0,0 +1,393 @@
+#pragma once
+
+#include <array>
+#include <binsparse/binsparse.hpp>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace binsparse {
+
+/// The formats an `any_matrix` can hold.  Row and column-sorted COO matrices
+/// are both held as `coo`.
+enum class matrix_format : std::uint8_t {
+  dvec,
+  dmatr,
+  dmatc,
+  csr,
+  csc,
+  coo,
+  dcsr,
+  dcsc
+};
+
+/// The types of the values of an `any_matrix`, in the order of
+/// `any_matrix::value_types`.
+enum class value_type : std::uint8_t {
+  uint8,
+  uint16,
+  uint32,
+  uint64,
+  int8,
+  int16,
+  int32,
+  int64,
+  float32,
+  float64,
+  bint8
+};
+
+/// The types in which an `any_matrix` holds its indices and pointers, in the
+/// order of `any_matrix::index_types`.
+enum class index_type : std::uint8_t { uint32, uint64 };
+
+class any_matrix;
+
+namespace __detail {
+
+template <typename Source>
+any_matrix read_matrix_impl(Source& f,
+                            const nlohmann::json& binsparse_metadata);
+
+} // namespace __detail
+
+/// A matrix whose format and types are only known at run time, as returned
+/// by `read_matrix`.  It owns its arrays, which copies of it share.  Values
+/// are held in their stored type.  Indices and pointers are held as
+/// `std::uint32_t` when every index and pointer fits, and as `std::uint64_t`
+/// otherwise, so `visit` need only handle those two types.
+class any_matrix {
+public:
+  using value_types =
+      std::tuple<std::uint8_t, std::uint16_t, std::uint32_t, std::uint64_t,
+                 std::int8_t, std::int16_t, std::int32_t, std::int64_t,
+                 float, double, bool>;
+  using index_types = std::tuple<std::uint32_t, std::uint64_t>;
+
+  matrix_format format() const {
+    return format_;
+  }
+
+  value_type values_type() const {
+    return values_type_;
+  }
+
+  index_type indices_type() const {
+    return indices_type_;
+  }
+
+  index_type pointers_type() const {
+    return pointers_type_;
+  }
+
+  std::size_t m() const {
+    return m_;
+  }
+
+  std::size_t n() const {
+    return n_;
+  }
+
+  std::size_t nnz() const {
+    return nnz_;
+  }
+
+  structure_t structure() const {
+    return structure_;
+  }
+
+  /// Invoke `fn` with the matrix as a typed container whose arrays point into
+  /// this matrix: a `std::span<T>` for dense vectors, a
+  /// `dense_matrix<T, I, row_major>` or `dense_matrix<T, I, column_major>`
+  /// for dense matrices, and a `csr_matrix<T, I, P>`, `csc_matrix<T, I, P>`,
+  /// `coo_matrix<T, I>`, `dcsr_matrix<T, I, P>` or `dcsc_matrix<T, I, P>` for
+  /// sparse ones.  The call is made through a table of function pointers
+  /// built at compile time, indexed by format and types, so no labels are
+  /// compared.  As with `std::visit`, `fn` must return the same type for
+  /// every container.
+  template <typename Fn>
+  decltype(auto) visit(Fn&& fn) const {
+    using R = std::invoke_result_t<Fn&, std::span<std::uint8_t>>;
+
+    constexpr auto table = []<std::size_t... Entries>(
+                               std::index_sequence<Entries...>) {
+      return std::array<R (*)(const any_matrix&, Fn&), sizeof...(Entries)>{
+          table_entry<Entries, R, Fn>()...};
+    }(std::make_index_sequence<num_entries>{});
+
+    std::size_t entry = std::size_t(format_);
+    entry = entry * num_value_types + std::size_t(values_type_);
+    entry = entry * num_index_types + std::size_t(indices_type_);
+    entry = entry * num_index_types + std::size_t(pointers_type_);
+
+    return table[entry](*this, fn);
+  }
+
+private:
+  template <typename Source>
+  friend any_matrix __detail::read_matrix_impl(Source& f,
+                                               const nlohmann::json&);
+
+  static constexpr std::size_t num_formats = 8;
+  static constexpr std::size_t num_value_types =
+      std::tuple_size_v<value_types>;
+  static constexpr std::size_t num_index_types =
+      std::tuple_size_v<index_types>;
+  static constexpr std::size_t num_entries =
+      num_formats * num_value_types * num_index_types * num_index_types;
+
+  any_matrix() = default;
+
+  // The function for table entry `Entry`.  Entries for index and pointer
+  // types that a format does not use share one function.
+  template <std::size_t Entry, typename R, typename Fn>
+  static constexpr auto table_entry() {
+    constexpr std::size_t pointer = Entry % num_index_types;
+    constexpr std::size_t index = Entry / num_index_types % num_index_types;
+    constexpr std::size_t value =
+        Entry / (num_index_types * num_index_types) % num_value_types;
+    constexpr auto format = matrix_format(
+        Entry / (num_index_types * num_index_types * num_value_types));
+
+    constexpr bool has_indices = format != matrix_format::dvec;
+    constexpr bool has_pointers =
+        format == matrix_format::csr || format == matrix_format::csc ||
+        format == matrix_format::dcsr || format == matrix_format::dcsc;
+
+    using T = std::tuple_element_t<value, value_types>;
+    using I = std::tuple_element_t<has_indices ? index : 0, index_types>;
+    using P = std::tuple_element_t<has_pointers ? pointer : 0, index_types>;
+
+    return &invoke_as<format, T, I, P, R, Fn>;
+  }
+
+  template <matrix_format Format, typename T, typename I, typename P,
+            typename R, typename Fn>
+  static R invoke_as(const any_matrix& m, Fn& fn) {
+    auto values = array<T>(m.values_);
+
+    if constexpr (Format == matrix_format::dvec) {
+      return std::invoke(fn, std::span<T>(values, m.nnz_));
+    } else if constexpr (Format == matrix_format::dmatr) {
+      return std::invoke(fn, dense_matrix<T, I, row_major>{
+                                 values, I(m.m_), I(m.n_), m.structure_});
+    } else if constexpr (Format == matrix_format::dmatc) {
+      return std::invoke(fn, dense_matrix<T, I, column_major>{
+                                 values, I(m.m_), I(m.n_), m.structure_});
+    } else if constexpr (Format == matrix_format::csr) {
+      return std::invoke(
+          fn, csr_matrix<T, I, P>{values, array<I>(m.indices_1_),
+                                  array<P>(m.pointers_), I(m.m_), I(m.n_),
+                                  P(m.nnz_), m.structure_});
+    } else if constexpr (Format == matrix_format::csc) {
+      return std::invoke(
+          fn, csc_matrix<T, I, P>{values, array<I>(m.indices_1_),
+                                  array<P>(m.pointers_), I(m.m_), I(m.n_),
+                                  P(m.nnz_), m.structure_});
+    } else if constexpr (Format == matrix_format::coo) {
+      return std::invoke(
+          fn, coo_matrix<T, I>{values, array<I>(m.indices_0_),
+                               array<I>(m.indices_1_), I(m.m_), I(m.n_),
+                               I(m.nnz_), m.structure_});
+    } else if constexpr (Format == matrix_format::dcsr) {
+      return std::invoke(
+          fn, dcsr_matrix<T, I, P>{values, array<I>(m.indices_1_),
+                                   array<P>(m.pointers_),
+                                   array<I>(m.indices_0_), I(m.m_), I(m.n_),
+                                   P(m.nnz_), I(m.stored_), m.structure_});
+    } else {
+      return std::invoke(
+          fn, dcsc_matrix<T, I, P>{values, array<I>(m.indices_1_),
+                                   array<P>(m.pointers_),
+                                   array<I>(m.indices_0_), I(m.m_), I(m.n_),
+                                   P(m.nnz_), I(m.stored_), m.structure_});
+    }
+  }
+
+  template <typename U>
+  static U* array(const std::shared_ptr<void>& data) {
+    return static_cast<U*>(data.get());
+  }
+
+  matrix_format format_;
+  value_type values_type_;
+  index_type indices_type_ = index_type::uint32;
+  index_type pointers_type_ = index_type::uint32;
+
+  std::size_t m_;
+  std::size_t n_;
+  std::size_t nnz_;
+  // Number of rows or columns stored by a DCSR or DCSC matrix.
+  std::size_t stored_ = 0;
+  structure_t structure_ = general;
+
+  std::shared_ptr<void> values_;
+  std::shared_ptr<void> indices_0_;
+  std::shared_ptr<void> indices_1_;
+  std::shared_ptr<void> pointers_;
+};
+
+namespace __detail {
+
+inline matrix_format get_matrix_format(const std::string& format) {
+  if (format == "DVEC") {
+    return matrix_format::dvec;
+  } else if (format == "DMATR") {
+    return matrix_format::dmatr;
+  } else if (format == "DMATC") {
+    return matrix_format::dmatc;
+  } else if (format == "CSR") {
+    return matrix_format::csr;
+  } else if (format == "CSC") {
+    return matrix_format::csc;
+  } else if (format == "COOR" || format == "COOC") {
+    return matrix_format::coo;
+  } else if (format == "DCSR") {
+    return matrix_format::dcsr;
+  } else if (format == "DCSC") {
+    return matrix_format::dcsc;
+  } else {
+    throw std::runtime_error("read_matrix: unsupported format " + format);
+  }
+}
+
+inline value_type get_value_type(const std::string& label) {
+  std::optional<value_type> type;
+  [&]<std::size_t... Ts>(std::index_sequence<Ts...>) {
+    ((label == type_info<std::tuple_element_t<
+                   Ts, any_matrix::value_types>>::label()
+          ? (type = value_type(Ts), true)
+          : false) ||
+     ...);
+  }(std::make_index_sequence<std::tuple_size_v<any_matrix::value_types>>{});
+
+  if (!type.has_value()) {
+    throw std::runtime_error("read_matrix: unsupported value type " + label);
+  }
+  return type.value();
+}
+
+// The narrowest type in `any_matrix::index_types` that holds `bound`.
+inline index_type get_index_type(std::size_t bound) {
+  return bound <= std::numeric_limits<std::uint32_t>::max()
+             ? index_type::uint32
+             : index_type::uint64;
+}
+
+// Read the dataset `label` as elements of type `U`, converting it from its
+// stored type if need be.  `bool` values are read as bytes.
+template <typename U, typename Source>
+std::shared_ptr<void> read_array_as(Source& f, const std::string& label) {
+  if constexpr (std::is_same_v<U, bool>) {
+    auto bytes = hdf5_tools::read_dataset<std::uint8_t>(f, label);
+    std::shared_ptr<bool[]> data(new bool[bytes.size()]);
+    for (std::size_t k = 0; k < bytes.size(); k++) {
+      data[k] = bytes[k] != 0;
+    }
+    std::allocator<std::uint8_t>{}.deallocate(bytes.data(), bytes.size());
+    return data;
+  } else {
+    auto data = hdf5_tools::read_dataset<U>(f, label);
+    return std::shared_ptr<void>(data.data(), [size = data.size()](void* p) {
+      std::allocator<U>{}.deallocate(static_cast<U*>(p), size);
+    });
+  }
+}
+
+// Read the dataset `label` as elements of the type with index `type` in the
+// tuple `Types`.
+template <typename Types, typename Source>
+std::shared_ptr<void> read_any_array(Source& f, const std::string& label,
+                                     std::size_t type) {
+  constexpr auto readers = []<std::size_t... Ts>(std::index_sequence<Ts...>) {
+    return std::array{
+        &read_array_as<std::tuple_element_t<Ts, Types>, Source>...};
+  }(std::make_index_sequence<std::tuple_size_v<Types>>{});
+
+  return readers[type](f, label);
+}
+
+template <typename Source>
+any_matrix read_matrix_impl(Source& f,
+                            const nlohmann::json& binsparse_metadata) {
+  any_matrix matrix;
+
+  auto format = unalias_format(binsparse_metadata["format"]);
+  matrix.format_ = get_matrix_format(format);
+
+  auto&& shape = binsparse_metadata["shape"];
+  matrix.m_ = shape[0];
+  matrix.n_ = shape.size() > 1 ? std::size_t(shape[1]) : std::size_t(1);
+  matrix.nnz_ = binsparse_metadata["nnz"];
+  matrix.structure_ = read_structure(binsparse_metadata);
+
+  matrix.values_type_ =
+      get_value_type(binsparse_metadata["data_types"]["values"]);
+  matrix.values_ = read_any_array<any_matrix::value_types>(
+      f, "values", std::size_t(matrix.values_type_));
+
+  using index_types = any_matrix::index_types;
+
+  if (matrix.format_ != matrix_format::dvec) {
+    // COO matrices also count their stored values with the index type.
+    std::size_t bound = std::max(matrix.m_, matrix.n_);
+    if (matrix.format_ == matrix_format::coo) {
+      bound = std::max(bound, matrix.nnz_);
+    }
+    matrix.indices_type_ = get_index_type(bound);
+  }
+
+  auto indices_type = std::size_t(matrix.indices_type_);
+
+  bool doubly_compressed = matrix.format_ == matrix_format::dcsr ||
+                           matrix.format_ == matrix_format::dcsc;
+  bool compressed = doubly_compressed || matrix.format_ == matrix_format::csr ||
+                    matrix.format_ == matrix_format::csc;
+
+  if (matrix.format_ == matrix_format::coo || doubly_compressed) {
+    matrix.indices_0_ =
+        read_any_array<index_types>(f, "indices_0", indices_type);
+  }
+
+  if (matrix.format_ == matrix_format::coo || compressed) {
+    matrix.indices_1_ =
+        read_any_array<index_types>(f, "indices_1", indices_type);
+  }
+
+  if (compressed) {
+    matrix.pointers_type_ = get_index_type(matrix.nnz_);
+    matrix.pointers_ = read_any_array<index_types>(
+        f, "pointers_to_1", std::size_t(matrix.pointers_type_));
+  }
+
+  if (doubly_compressed) {
+    H5::DataSet dataset = f.openDataSet("indices_0");
+    matrix.stored_ = dataset.getSpace().getSimpleExtentNpoints();
+  }
+
+  return matrix;
+}
+
+} // namespace __detail
+
+/// Read the matrix stored in `f`, whatever its format and types, as an
+/// `any_matrix`.
+inline any_matrix read_matrix(H5::Group& f) {
+  auto binsparse_metadata = __detail::read_binsparse_metadata(f);
+  return __detail::read_matrix_impl(f, binsparse_metadata);
+}
+
+inline any_matrix read_matrix(std::string fname) {
+  auto f = hdf5_tools::open_read_only(fname);
+  return read_matrix(f);
+}
+
+} // namespace binsparse
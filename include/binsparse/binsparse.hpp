@@ -2,11 +2,20 @@
 
 #include "hdf5_tools.hpp"
 #include "type_info.hpp"
+#include <algorithm>
 #include <binsparse/containers/matrices.hpp>
 #include <binsparse/detail.hpp>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <nlohmann/json.hpp>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <tuple>
 #include <type_traits>
+#include <vector>
 
 #include <binsparse/c_bindings/allocator_wrapper.hpp>
 #include <binsparse/matrix_market/matrix_market.hpp>
@@ -15,10 +24,247 @@ namespace binsparse {
 
 inline constexpr double version = 0.1;
 
+using hdf5_tools::write_options;
+
+namespace __detail {
+
+// Parse the "binsparse" object of the metadata stored in the attribute of `f`.
+inline nlohmann::json read_binsparse_metadata(H5::Group& f) {
+  auto metadata = hdf5_tools::get_attribute(f, "binsparse");
+  return nlohmann::json::parse(metadata)["binsparse"];
+}
+
+inline structure_t read_structure(const nlohmann::json& binsparse_metadata) {
+  if (binsparse_metadata.contains("structure")) {
+    return parse_structure(binsparse_metadata["structure"]);
+  }
+  return general;
+}
+
+// Returns the largest element of the index array `r`, or no value if it
+// holds a negative index.  Each thread reduces a block with a plain min/max
+// loop, which the compiler vectorizes.
+template <typename I>
+std::optional<std::uint64_t> max_index(std::span<const I> r,
+                                       std::size_t num_threads) {
+  if (r.empty()) {
+    return 0;
+  }
+
+  std::size_t nt = std::max<std::size_t>(
+      1, std::min(num_threads, r.size() / (std::size_t(1) << 16)));
+
+  std::vector<I> lows(nt);
+  std::vector<I> highs(nt);
+  parallel_for(nt, [&](std::size_t t) {
+    auto [first, last] = block_range(r.size(), t, nt);
+    I low = r[first];
+    I high = r[first];
+    for (std::size_t k = first; k < last; k++) {
+      low = std::min(low, r[k]);
+      high = std::max(high, r[k]);
+    }
+    lows[t] = low;
+    highs[t] = high;
+  });
+
+  if constexpr (std::is_signed_v<I>) {
+    if (*std::ranges::min_element(lows) < 0) {
+      return {};
+    }
+  }
+  return std::uint64_t(*std::ranges::max_element(highs));
+}
+
+// Write `r` into a new dataset of the narrower unsigned type `U`.  Elements
+// are converted a block of whole chunks at a time, so the conversion needs
+// only a bounded buffer.  Each block holds several chunks per thread, so that
+// the chunks are still compressed in parallel and written directly.
+template <typename U, typename I>
+void write_narrowed_dataset(H5::Group& f, const std::string& label,
+                            std::span<const I> r,
+                            const write_options& options) {
+  auto dataset = hdf5_tools::create_dataset<U>(f, label, r.size(), options);
+
+  std::size_t num_threads = std::max<std::size_t>(1, options.num_threads);
+  std::size_t chunk = options.chunk_size<U>(r.size());
+  std::size_t block = std::max<std::size_t>(4 * chunk * num_threads, 1 << 16);
+  block = (block + chunk - 1) / chunk * chunk;
+  std::vector<U> buffer(std::min(block, r.size()));
+
+  for (std::size_t offset = 0; offset < r.size(); offset += block) {
+    std::size_t count = std::min(block, r.size() - offset);
+    parallel_for(num_threads, [&](std::size_t t) {
+      auto [first, last] = block_range(count, t, num_threads);
+      for (std::size_t k = first; k < last; k++) {
+        buffer[k] = U(r[offset + k]);
+      }
+    });
+    hdf5_tools::write_dataset(dataset, offset,
+                              std::span<const U>(buffer.data(), count),
+                              options.num_threads);
+  }
+}
+
+// Write the index array `r` as the dataset `label`, stored in the smallest
+// unsigned integer type that holds its elements if `options.narrow_indices`
+// is set.  Returns the label of the type stored, for the metadata.
+template <typename I>
+std::string write_index_dataset(H5::Group& f, const std::string& label,
+                                std::span<const I> r,
+                                const write_options& options) {
+  if constexpr (std::is_integral_v<I> && sizeof(I) > 1) {
+    if (options.narrow_indices) {
+      auto max = max_index(r, options.num_threads);
+      if (max.has_value()) {
+        if (*max <= std::numeric_limits<std::uint8_t>::max()) {
+          write_narrowed_dataset<std::uint8_t>(f, label, r, options);
+          return type_info<std::uint8_t>::label();
+        } else if (sizeof(I) > 2 &&
+                   *max <= std::numeric_limits<std::uint16_t>::max()) {
+          write_narrowed_dataset<std::uint16_t>(f, label, r, options);
+          return type_info<std::uint16_t>::label();
+        } else if (sizeof(I) > 4 &&
+                   *max <= std::numeric_limits<std::uint32_t>::max()) {
+          write_narrowed_dataset<std::uint32_t>(f, label, r, options);
+          return type_info<std::uint32_t>::label();
+        }
+      }
+    }
+  }
+
+  hdf5_tools::write_dataset(f, label, r, options);
+  return type_info<I>::label();
+}
+
+// The arrays of a contiguous range of rows of a CSR matrix, or of columns of
+// a CSC matrix.
+template <typename T, typename I, typename P>
+struct compressed_range {
+  T* values;
+  I* indices;
+  P* pointers;
+  P nnz;
+};
+
+// Read the major dimension range [first, last) of the compressed matrix
+// stored in `f`.  Only the `last - first + 1` pointers covering the range are
+// read, followed by the matching slices of the indices and values; the
+// pointers are rebased to start at zero.
+template <typename T, typename I, typename P, typename Source,
+          typename Allocator>
+compressed_range<T, I, P> read_compressed_range(Source& f, std::size_t first,
+                                                std::size_t last,
+                                                Allocator&& alloc) {
+  typename std::allocator_traits<
+      std::remove_cvref_t<Allocator>>::template rebind_alloc<I>
+      i_alloc(alloc);
+  typename std::allocator_traits<
+      std::remove_cvref_t<Allocator>>::template rebind_alloc<P>
+      p_alloc(alloc);
+
+  P* pointers = p_alloc.allocate(last - first + 1);
+  auto pointers_dataset = f.openDataSet("pointers_to_1");
+  hdf5_tools::read_dataset(pointers_dataset, first, last - first + 1,
+                           pointers);
+
+  P offset = pointers[0];
+  P nnz = pointers[last - first] - offset;
+  for (std::size_t i = 0; i <= last - first; i++) {
+    pointers[i] -= offset;
+  }
+
+  T* values = alloc.allocate(nnz);
+  auto values_dataset = f.openDataSet("values");
+  hdf5_tools::read_dataset(values_dataset, offset, nnz, values);
+
+  I* indices = i_alloc.allocate(nnz);
+  auto indices_dataset = f.openDataSet("indices_1");
+  hdf5_tools::read_dataset(indices_dataset, offset, nnz, indices);
+
+  return {values, indices, pointers, nnz};
+}
+
+template <typename T, typename I, typename P, typename Source,
+          typename Allocator>
+csr_matrix<T, I, P> read_csr_rows_impl(Source& f,
+                                       const nlohmann::json& binsparse_metadata,
+                                       std::size_t row_begin,
+                                       std::size_t row_end, Allocator&& alloc) {
+  assert(binsparse_metadata["format"] == "CSR");
+
+  std::size_t nrows = binsparse_metadata["shape"][0];
+  I ncols = binsparse_metadata["shape"][1];
+
+  if (row_begin > row_end || row_end > nrows) {
+    throw std::out_of_range("read_csr_rows: row range out of bounds.");
+  }
+
+  auto range = read_compressed_range<T, I, P>(f, row_begin, row_end, alloc);
+
+  structure_t structure = general;
+
+  if (binsparse_metadata.contains("structure")) {
+    structure = __detail::parse_structure(binsparse_metadata["structure"]);
+  }
+
+  return csr_matrix<T, I, P>{range.values,
+                             range.indices,
+                             range.pointers,
+                             I(row_end - row_begin),
+                             ncols,
+                             range.nnz,
+                             structure};
+}
+
+template <typename T, typename I, typename P, typename Source,
+          typename Allocator>
+csc_matrix<T, I, P> read_csc_cols_impl(Source& f,
+                                       const nlohmann::json& binsparse_metadata,
+                                       std::size_t col_begin,
+                                       std::size_t col_end, Allocator&& alloc) {
+  assert(binsparse_metadata["format"] == "CSC");
+
+  I nrows = binsparse_metadata["shape"][0];
+  std::size_t ncols = binsparse_metadata["shape"][1];
+
+  if (col_begin > col_end || col_end > ncols) {
+    throw std::out_of_range("read_csc_cols: column range out of bounds.");
+  }
+
+  auto range = read_compressed_range<T, I, P>(f, col_begin, col_end, alloc);
+
+  structure_t structure = general;
+
+  if (binsparse_metadata.contains("structure")) {
+    structure = __detail::parse_structure(binsparse_metadata["structure"]);
+  }
+
+  return csc_matrix<T, I, P>{range.values,
+                             range.indices,
+                             range.pointers,
+                             nrows,
+                             I(col_end - col_begin),
+                             range.nnz,
+                             structure};
+}
+
+} // namespace __detail
+
+/// Enable or disable HDF5 file locking for files opened by the readers.
+/// Locking is enabled by default; disabling it lets many processes read one
+/// file without contending on the lock, and allows reading from file systems
+/// that do not support locking.  Files must not be written while they are
+/// being read without a lock.
+inline void set_file_locking(bool enabled) {
+  hdf5_tools::use_file_locking = enabled;
+}
+
 template <typename T>
 void write_dense_vector(H5::Group& f, std::span<T> v,
-                        nlohmann::json user_keys = {}) {
-  hdf5_tools::write_dataset(f, "values", v);
+                        nlohmann::json user_keys = {},
+                        const write_options& options = {}) {
+  hdf5_tools::write_dataset(f, "values", v, options);
 
   using json = nlohmann::json;
   json j;
@@ -35,17 +281,12 @@ void write_dense_vector(H5::Group& f, std::span<T> v,
   hdf5_tools::set_attribute(f, "binsparse", j.dump(2));
 }
 
-template <typename T, typename Allocator = std::allocator<T>>
-auto read_dense_vector(std::string fname, Allocator&& alloc = Allocator{}) {
-  H5::H5File f(fname.c_str(), H5F_ACC_RDWR);
-
-  auto metadata = hdf5_tools::get_attribute(f, "binsparse");
-
-  using json = nlohmann::json;
-  auto data = json::parse(metadata);
-
-  auto binsparse_metadata = data["binsparse"];
+namespace __detail {
 
+template <typename T, typename Source, typename Allocator>
+auto read_dense_vector_impl(Source& f,
+                            const nlohmann::json& binsparse_metadata,
+                            Allocator&& alloc) {
   auto format = __detail::unalias_format(binsparse_metadata["format"]);
 
   assert(format == "DVEC");
@@ -62,14 +303,59 @@ auto read_dense_vector(std::string fname, Allocator&& alloc = Allocator{}) {
   return values;
 }
 
+} // namespace __detail
+
+template <typename T, typename Allocator = std::allocator<T>>
+auto read_dense_vector(H5::Group& f, Allocator&& alloc = Allocator{}) {
+  auto binsparse_metadata = __detail::read_binsparse_metadata(f);
+  return __detail::read_dense_vector_impl<T>(f, binsparse_metadata, alloc);
+}
+
+template <typename T, typename Allocator = std::allocator<T>>
+auto read_dense_vector(std::string fname, Allocator&& alloc = Allocator{}) {
+  auto f = hdf5_tools::open_read_only(fname);
+  return read_dense_vector<T>(f, alloc);
+}
+
+namespace __detail {
+
+template <typename T, typename Source, typename A>
+std::span<T> read_dense_vector_into_impl(
+    Source& f, const nlohmann::json& binsparse_metadata,
+    std::vector<T, A>& values) {
+  auto format = __detail::unalias_format(binsparse_metadata["format"]);
+
+  assert(format == "DVEC");
+
+  return hdf5_tools::read_dataset_into(f, "values", values);
+}
+
+} // namespace __detail
+
+/// Read the dense vector stored in `f` into `values`, reusing its storage.
+/// Reloading a vector of the same or a smaller size allocates no memory.
+template <typename T, typename A>
+std::span<T> read_dense_vector_into(H5::Group& f, std::vector<T, A>& values) {
+  auto binsparse_metadata = __detail::read_binsparse_metadata(f);
+  return __detail::read_dense_vector_into_impl(f, binsparse_metadata, values);
+}
+
+template <typename T, typename A>
+std::span<T> read_dense_vector_into(std::string fname,
+                                    std::vector<T, A>& values) {
+  auto f = hdf5_tools::open_read_only(fname);
+  return read_dense_vector_into(f, values);
+}
+
 // Dense Format
 
 template <typename T, typename I, typename Order>
 void write_dense_matrix(H5::Group& f, dense_matrix<T, I, Order> m,
-                        nlohmann::json user_keys = {}) {
+                        nlohmann::json user_keys = {},
+                        const write_options& options = {}) {
   std::span<T> values(m.values, m.m * m.n);
 
-  hdf5_tools::write_dataset(f, "values", values);
+  hdf5_tools::write_dataset(f, "values", values, options);
 
   using json = nlohmann::json;
   json j;
@@ -93,24 +379,20 @@ void write_dense_matrix(H5::Group& f, dense_matrix<T, I, Order> m,
 
 template <typename T, typename I, typename Order>
 void write_dense_matrix(std::string fname, dense_matrix<T, I, Order> m,
-                        nlohmann::json user_keys = {}) {
+                        nlohmann::json user_keys = {},
+                        const write_options& options = {}) {
   H5::H5File f(fname.c_str(), H5F_ACC_TRUNC);
-  write_dense_matrix(f, m, user_keys);
+  write_dense_matrix(f, m, user_keys, options);
   f.close();
 }
 
-template <typename T, typename I, typename Order,
-          typename Allocator = std::allocator<T>>
-auto read_dense_matrix(std::string fname, Allocator&& alloc = Allocator{}) {
-  H5::H5File f(fname.c_str(), H5F_ACC_RDWR);
-
-  auto metadata = hdf5_tools::get_attribute(f, "binsparse");
-
-  using json = nlohmann::json;
-  auto data = json::parse(metadata);
-
-  auto binsparse_metadata = data["binsparse"];
+namespace __detail {
 
+template <typename T, typename I, typename Order, typename Source,
+          typename Allocator>
+auto read_dense_matrix_impl(Source& f,
+                            const nlohmann::json& binsparse_metadata,
+                            Allocator&& alloc) {
   auto format = __detail::unalias_format(binsparse_metadata["format"]);
 
   assert(format ==
@@ -131,18 +413,79 @@ auto read_dense_matrix(std::string fname, Allocator&& alloc = Allocator{}) {
   return dense_matrix<T, I, Order>{values.data(), nrows, ncols, structure};
 }
 
+} // namespace __detail
+
+template <typename T, typename I, typename Order,
+          typename Allocator = std::allocator<T>>
+auto read_dense_matrix(H5::Group& f, Allocator&& alloc = Allocator{}) {
+  auto binsparse_metadata = __detail::read_binsparse_metadata(f);
+  return __detail::read_dense_matrix_impl<T, I, Order>(f, binsparse_metadata,
+                                                       alloc);
+}
+
+template <typename T, typename I, typename Order,
+          typename Allocator = std::allocator<T>>
+auto read_dense_matrix(std::string fname, Allocator&& alloc = Allocator{}) {
+  auto f = hdf5_tools::open_read_only(fname);
+  return read_dense_matrix<T, I, Order>(f, alloc);
+}
+
+namespace __detail {
+
+template <typename T, typename I, typename Order, typename Source, typename A>
+dense_matrix<T, I, Order>
+read_dense_matrix_into_impl(Source& f, const nlohmann::json& binsparse_metadata,
+                            std::vector<T, A>& values) {
+  auto format = __detail::unalias_format(binsparse_metadata["format"]);
+
+  assert(format ==
+         __detail::get_matrix_format_string(dense_matrix<T, I, Order>{}));
+
+  I nrows = binsparse_metadata["shape"][0];
+  I ncols = binsparse_metadata["shape"][1];
+
+  hdf5_tools::read_dataset_into(f, "values", values);
+
+  auto structure = __detail::read_structure(binsparse_metadata);
+
+  return dense_matrix<T, I, Order>{values.data(), nrows, ncols, structure};
+}
+
+} // namespace __detail
+
+/// Read the dense matrix stored in `f` into `values`, reusing its storage,
+/// and return a view of it.  Reloading a matrix of the same or a smaller size
+/// allocates no memory.
+template <typename T, typename I, typename Order, typename A>
+dense_matrix<T, I, Order> read_dense_matrix_into(H5::Group& f,
+                                                 std::vector<T, A>& values) {
+  auto binsparse_metadata = __detail::read_binsparse_metadata(f);
+  return __detail::read_dense_matrix_into_impl<T, I, Order>(
+      f, binsparse_metadata, values);
+}
+
+template <typename T, typename I, typename Order, typename A>
+dense_matrix<T, I, Order> read_dense_matrix_into(std::string fname,
+                                                 std::vector<T, A>& values) {
+  auto f = hdf5_tools::open_read_only(fname);
+  return read_dense_matrix_into<T, I, Order>(f, values);
+}
+
 // CSR Format
 
-template <typename T, typename I>
-void write_csr_matrix(H5::Group& f, csr_matrix<T, I> m,
-                      nlohmann::json user_keys = {}) {
+template <typename T, typename I, typename P>
+void write_csr_matrix(H5::Group& f, csr_matrix<T, I, P> m,
+                      nlohmann::json user_keys = {},
+                      const write_options& options = {}) {
   std::span<T> values(m.values, m.nnz);
   std::span<I> colind(m.colind, m.nnz);
-  std::span<I> row_ptr(m.row_ptr, m.m + 1);
+  std::span<P> row_ptr(m.row_ptr, m.m + 1);
 
-  hdf5_tools::write_dataset(f, "values", values);
-  hdf5_tools::write_dataset(f, "indices_1", colind);
-  hdf5_tools::write_dataset(f, "pointers_to_1", row_ptr);
+  hdf5_tools::write_dataset(f, "values", values, options);
+  auto colind_type = __detail::write_index_dataset<I>(f, "indices_1", colind,
+                                                      options);
+  auto row_ptr_type = __detail::write_index_dataset<P>(f, "pointers_to_1",
+                                                       row_ptr, options);
 
   using json = nlohmann::json;
   json j;
@@ -150,8 +493,8 @@ void write_csr_matrix(H5::Group& f, csr_matrix<T, I> m,
   j["binsparse"]["format"] = "CSR";
   j["binsparse"]["shape"] = {m.m, m.n};
   j["binsparse"]["nnz"] = m.nnz;
-  j["binsparse"]["data_types"]["pointers_to_1"] = type_info<I>::label();
-  j["binsparse"]["data_types"]["indices_1"] = type_info<I>::label();
+  j["binsparse"]["data_types"]["pointers_to_1"] = row_ptr_type;
+  j["binsparse"]["data_types"]["indices_1"] = colind_type;
   j["binsparse"]["data_types"]["values"] = type_info<T>::label();
 
   if (m.structure != general) {
@@ -166,25 +509,131 @@ void write_csr_matrix(H5::Group& f, csr_matrix<T, I> m,
   hdf5_tools::set_attribute(f, "binsparse", j.dump(2));
 }
 
-template <typename T, typename I>
-void write_csr_matrix(std::string fname, csr_matrix<T, I> m,
-                      nlohmann::json user_keys = {}) {
+template <typename T, typename I, typename P>
+void write_csr_matrix(std::string fname, csr_matrix<T, I, P> m,
+                      nlohmann::json user_keys = {},
+                      const write_options& options = {}) {
   H5::H5File f(fname.c_str(), H5F_ACC_TRUNC);
-  write_csr_matrix(f, m, user_keys);
+  write_csr_matrix(f, m, user_keys, options);
   f.close();
 }
 
-template <typename T, typename I, typename Allocator>
-csr_matrix<T, I> read_csr_matrix(std::string fname, Allocator&& alloc) {
-  H5::H5File f(fname.c_str(), H5F_ACC_RDWR);
+namespace __detail {
 
-  auto metadata = hdf5_tools::get_attribute(f, "binsparse");
+// Projection returning element `N` of a tuple-like entry.
+template <std::size_t N>
+struct get_element {
+  template <typename Tuple>
+  decltype(auto) operator()(Tuple&& t) const {
+    using std::get;
+    return get<N>(std::forward<Tuple>(t));
+  }
+};
+
+// Size of the range `r` if it is known without iterating over it.
+template <std::ranges::input_range R>
+std::optional<hsize_t> known_size(R&& r) {
+  if constexpr (std::ranges::sized_range<R>) {
+    return std::ranges::size(r);
+  } else {
+    return {};
+  }
+}
+
+} // namespace __detail
+
+/// Write an `m` by `n` CSR matrix whose stored values are the elements of
+/// `entries`, an input range such as a generator or an edge list, without
+/// first copying it into arrays.  The projections `row`, `col` and `value`
+/// return an entry's row, column and value; by default entries are
+/// tuple-like `(row, column, value)`.  Entries must be sorted by row.  Only
+/// the `m + 1` row pointers and one chunk of each array are held in memory.
+template <std::ranges::input_range R, typename I,
+          typename RowProj = __detail::get_element<0>,
+          typename ColProj = __detail::get_element<1>,
+          typename ValueProj = __detail::get_element<2>>
+void write_csr_matrix(H5::Group& f, R&& entries, I m, I n,
+                      nlohmann::json user_keys = {},
+                      const write_options& options = {}, RowProj row = {},
+                      ColProj col = {}, ValueProj value = {}) {
+  using T = std::remove_cvref_t<
+      std::invoke_result_t<ValueProj&, std::ranges::range_reference_t<R>>>;
+
+  auto size = __detail::known_size(entries);
+  hdf5_tools::dataset_appender<T> values(f, "values", options, size);
+  hdf5_tools::dataset_appender<I> colind(f, "indices_1", options, size);
+  std::vector<I> row_ptr(std::size_t(m) + 1, 0);
+
+  std::size_t last_row = 0;
+  for (auto&& entry : entries) {
+    std::size_t i = std::invoke(row, entry);
+    if (i >= std::size_t(m)) {
+      throw std::out_of_range("write_csr_matrix: row index out of bounds.");
+    }
+    if (i < last_row) {
+      throw std::invalid_argument(
+          "write_csr_matrix: entries are not sorted by row.");
+    }
+    last_row = i;
+
+    std::size_t j = std::invoke(col, entry);
+    if (j >= std::size_t(n)) {
+      throw std::out_of_range("write_csr_matrix: column index out of bounds.");
+    }
+
+    row_ptr[i + 1]++;
+    colind.push_back(I(j));
+    values.push_back(T(std::invoke(value, entry)));
+  }
+
+  for (std::size_t i = 0; i < std::size_t(m); i++) {
+    row_ptr[i + 1] += row_ptr[i];
+  }
+
+  std::size_t nnz = values.size();
+  values.close();
+  colind.close();
+  auto row_ptr_type = __detail::write_index_dataset<I>(f, "pointers_to_1",
+                                                       row_ptr, options);
 
   using json = nlohmann::json;
-  auto data = json::parse(metadata);
+  json j;
+  j["binsparse"]["version"] = version;
+  j["binsparse"]["format"] = "CSR";
+  j["binsparse"]["shape"] = {m, n};
+  j["binsparse"]["nnz"] = nnz;
+  j["binsparse"]["data_types"]["pointers_to_1"] = row_ptr_type;
+  j["binsparse"]["data_types"]["indices_1"] = type_info<I>::label();
+  j["binsparse"]["data_types"]["values"] = type_info<T>::label();
 
-  auto binsparse_metadata = data["binsparse"];
+  for (auto&& v : user_keys.items()) {
+    j[v.key()] = v.value();
+  }
+
+  hdf5_tools::set_attribute(f, "binsparse", j.dump(2));
+}
+
+template <std::ranges::input_range R, typename I,
+          typename RowProj = __detail::get_element<0>,
+          typename ColProj = __detail::get_element<1>,
+          typename ValueProj = __detail::get_element<2>>
+void write_csr_matrix(std::string fname, R&& entries, I m, I n,
+                      nlohmann::json user_keys = {},
+                      const write_options& options = {}, RowProj row = {},
+                      ColProj col = {}, ValueProj value = {}) {
+  H5::H5File f(fname.c_str(), H5F_ACC_TRUNC);
+  write_csr_matrix(f, std::forward<R>(entries), m, n, user_keys, options, row,
+                   col, value);
+  f.close();
+}
 
+namespace __detail {
+
+template <typename T, typename I, typename P, typename Source,
+          typename Allocator>
+csr_matrix<T, I, P>
+read_csr_matrix_impl(Source& f, const nlohmann::json& binsparse_metadata,
+                     Allocator&& alloc) {
   assert(binsparse_metadata["format"] == "CSR");
 
   auto nrows = binsparse_metadata["shape"][0];
@@ -195,9 +644,13 @@ csr_matrix<T, I> read_csr_matrix(std::string fname, Allocator&& alloc) {
       std::remove_cvref_t<Allocator>>::template rebind_alloc<I>
       i_alloc(alloc);
 
+  typename std::allocator_traits<
+      std::remove_cvref_t<Allocator>>::template rebind_alloc<P>
+      p_alloc(alloc);
+
   auto values = hdf5_tools::read_dataset<T>(f, "values", alloc);
   auto colind = hdf5_tools::read_dataset<I>(f, "indices_1", i_alloc);
-  auto row_ptr = hdf5_tools::read_dataset<I>(f, "pointers_to_1", i_alloc);
+  auto row_ptr = hdf5_tools::read_dataset<P>(f, "pointers_to_1", p_alloc);
 
   structure_t structure = general;
 
@@ -205,36 +658,289 @@ csr_matrix<T, I> read_csr_matrix(std::string fname, Allocator&& alloc) {
     structure = __detail::parse_structure(binsparse_metadata["structure"]);
   }
 
-  return csr_matrix<T, I>{values.data(), colind.data(), row_ptr.data(), nrows,
-                          ncols,         nnz,           structure};
+  return csr_matrix<T, I, P>{values.data(), colind.data(), row_ptr.data(),
+                             nrows,         ncols,         nnz,
+                             structure};
 }
 
-template <typename T, typename I>
-csr_matrix<T, I> read_csr_matrix(std::string fname) {
-  return read_csr_matrix<T, I>(fname, std::allocator<T>{});
+} // namespace __detail
+
+/// Read the CSR matrix stored in `f`.  The row pointers are read as `P`,
+/// which may be wider than the index type `I`.
+template <typename T, typename I, typename P = I, typename Allocator>
+csr_matrix<T, I, P> read_csr_matrix(H5::Group& f, Allocator&& alloc) {
+  auto binsparse_metadata = __detail::read_binsparse_metadata(f);
+  return __detail::read_csr_matrix_impl<T, I, P>(f, binsparse_metadata,
+                                                 alloc);
+}
+
+template <typename T, typename I, typename P = I, typename Allocator>
+csr_matrix<T, I, P> read_csr_matrix(std::string fname, Allocator&& alloc) {
+  auto f = hdf5_tools::open_read_only(fname);
+  return read_csr_matrix<T, I, P>(f, alloc);
+}
+
+template <typename T, typename I, typename P = I>
+csr_matrix<T, I, P> read_csr_matrix(H5::Group& f) {
+  return read_csr_matrix<T, I, P>(f, std::allocator<T>{});
+}
+
+template <typename T, typename I, typename P = I>
+csr_matrix<T, I, P> read_csr_matrix(std::string fname) {
+  return read_csr_matrix<T, I, P>(fname, std::allocator<T>{});
+}
+
+namespace __detail {
+
+template <typename T, typename I, typename P, typename Source, typename VA,
+          typename IA, typename PA>
+csr_matrix<T, I, P> read_csr_matrix_into_impl(
+    Source& f, const nlohmann::json& binsparse_metadata,
+    std::vector<T, VA>& values, std::vector<I, IA>& colind,
+    std::vector<P, PA>& row_ptr) {
+  assert(binsparse_metadata["format"] == "CSR");
+
+  I nrows = binsparse_metadata["shape"][0];
+  I ncols = binsparse_metadata["shape"][1];
+  P nnz = binsparse_metadata["nnz"];
+
+  hdf5_tools::read_dataset_into(f, "values", values);
+  hdf5_tools::read_dataset_into(f, "indices_1", colind);
+  hdf5_tools::read_dataset_into(f, "pointers_to_1", row_ptr);
+
+  auto structure = __detail::read_structure(binsparse_metadata);
+
+  return csr_matrix<T, I, P>{values.data(), colind.data(), row_ptr.data(),
+                             nrows,         ncols,         nnz,
+                             structure};
+}
+
+} // namespace __detail
+
+/// Read the CSR matrix stored in `f` into the vectors `values`, `colind` and
+/// `row_ptr`, and return a view of them.  The vectors' storage is reused, so
+/// a service that repeatedly reloads matrices of the same or a smaller size
+/// allocates no memory after the first load.
+template <typename T, typename I, typename P, typename VA, typename IA,
+          typename PA>
+csr_matrix<T, I, P> read_csr_matrix_into(H5::Group& f,
+                                         std::vector<T, VA>& values,
+                                         std::vector<I, IA>& colind,
+                                         std::vector<P, PA>& row_ptr) {
+  auto binsparse_metadata = __detail::read_binsparse_metadata(f);
+  return __detail::read_csr_matrix_into_impl(f, binsparse_metadata, values,
+                                             colind, row_ptr);
+}
+
+template <typename T, typename I, typename P, typename VA, typename IA,
+          typename PA>
+csr_matrix<T, I, P> read_csr_matrix_into(std::string fname,
+                                         std::vector<T, VA>& values,
+                                         std::vector<I, IA>& colind,
+                                         std::vector<P, PA>& row_ptr) {
+  auto f = hdf5_tools::open_read_only(fname);
+  return read_csr_matrix_into(f, values, colind, row_ptr);
+}
+
+/// Read rows [row_begin, row_end) of the CSR matrix stored in `f` as a
+/// `row_end - row_begin` by `n` CSR matrix.  Only the slices of the stored
+/// arrays that cover those rows are read.  The stored structure, if any, is
+/// reported unchanged.
+template <typename T, typename I, typename P = I,
+          typename Allocator = std::allocator<T>>
+csr_matrix<T, I, P> read_csr_rows(H5::Group& f, std::size_t row_begin,
+                                  std::size_t row_end,
+                                  Allocator&& alloc = Allocator{}) {
+  auto binsparse_metadata = __detail::read_binsparse_metadata(f);
+  return __detail::read_csr_rows_impl<T, I, P>(f, binsparse_metadata, row_begin,
+                                               row_end, alloc);
+}
+
+template <typename T, typename I, typename P = I,
+          typename Allocator = std::allocator<T>>
+csr_matrix<T, I, P> read_csr_rows(std::string fname, std::size_t row_begin,
+                                  std::size_t row_end,
+                                  Allocator&& alloc = Allocator{}) {
+  auto f = hdf5_tools::open_read_only(fname);
+  return read_csr_rows<T, I, P>(f, row_begin, row_end, alloc);
+}
+
+namespace __detail {
+
+// Name of the dataset holding precomputed boundaries for `num_partitions`
+// row partitions.
+inline std::string row_partitions_label(std::size_t num_partitions) {
+  return "row_partitions_" + std::to_string(num_partitions);
+}
+
+// Split the rows described by `row_ptr` into `num_partitions` contiguous
+// blocks with approximately equal numbers of nonzeros.  Returns the
+// `num_partitions + 1` block boundaries.  Block `p` starts at the first row
+// whose nonzeros begin at or after `p * nnz / num_partitions`.
+template <typename I>
+std::vector<std::uint64_t> balanced_row_partitions(std::span<const I> row_ptr,
+                                                   std::size_t num_partitions) {
+  assert(num_partitions > 0 && !row_ptr.empty());
+
+  std::size_t m = row_ptr.size() - 1;
+  std::size_t nnz = row_ptr[m] - row_ptr[0];
+
+  std::vector<std::uint64_t> boundaries(num_partitions + 1);
+  boundaries[0] = 0;
+  boundaries[num_partitions] = m;
+
+  for (std::size_t p = 1; p < num_partitions; p++) {
+    std::size_t target = row_ptr[0] + nnz * p / num_partitions;
+    auto row = std::lower_bound(row_ptr.begin(), row_ptr.end() - 1, target);
+    boundaries[p] = std::max<std::uint64_t>(boundaries[p - 1],
+                                            row - row_ptr.begin());
+  }
+
+  return boundaries;
+}
+
+template <typename Source>
+std::vector<std::uint64_t>
+partition_rows_impl(Source& f, const nlohmann::json& metadata,
+                    std::size_t num_partitions) {
+  auto&& binsparse_metadata = metadata["binsparse"];
+  assert(binsparse_metadata["format"] == "CSR");
+
+  if (num_partitions == 0) {
+    throw std::invalid_argument("partition_rows: no partitions requested.");
+  }
+
+  std::vector<std::uint64_t> boundaries;
+
+  if (metadata.contains("row_partitions")) {
+    for (auto&& stored : metadata["row_partitions"]) {
+      if (stored == num_partitions) {
+        boundaries.resize(num_partitions + 1);
+        auto dataset = f.openDataSet(
+            row_partitions_label(num_partitions).c_str());
+        hdf5_tools::read_dataset(dataset, 0, num_partitions + 1,
+                                 boundaries.data());
+        return boundaries;
+      }
+    }
+  }
+
+  std::size_t m = binsparse_metadata["shape"][0];
+  std::vector<std::uint64_t> row_ptr(m + 1);
+  auto dataset = f.openDataSet("pointers_to_1");
+  hdf5_tools::read_dataset(dataset, 0, m + 1, row_ptr.data());
+
+  return balanced_row_partitions(std::span<const std::uint64_t>(row_ptr),
+                                 num_partitions);
+}
+
+} // namespace __detail
+
+/// Split the rows of the CSR matrix stored in `f` into `num_partitions`
+/// contiguous blocks with approximately equal numbers of nonzeros, returning
+/// the `num_partitions + 1` block boundaries.  Boundaries stored by
+/// `write_row_partitions` are used when available; otherwise the row pointers
+/// are read and searched.
+inline std::vector<std::uint64_t> partition_rows(H5::Group& f,
+                                                 std::size_t num_partitions) {
+  auto metadata =
+      nlohmann::json::parse(hdf5_tools::get_attribute(f, "binsparse"));
+  return __detail::partition_rows_impl(f, metadata, num_partitions);
+}
+
+inline std::vector<std::uint64_t> partition_rows(std::string fname,
+                                                 std::size_t num_partitions) {
+  auto f = hdf5_tools::open_read_only(fname);
+  return partition_rows(f, num_partitions);
+}
+
+/// A block of rows of a CSR matrix, stored as a CSR matrix of its own.
+template <typename T, typename I, typename P = I>
+struct csr_partition {
+  csr_matrix<T, I, P> matrix;
+  std::size_t row_begin;
+  std::size_t row_end;
+};
+
+/// Read partition `p` of `num_partitions` nnz-balanced row partitions of the
+/// CSR matrix stored in `f`.
+template <typename T, typename I, typename P = I,
+          typename Allocator = std::allocator<T>>
+csr_partition<T, I, P> read_partition(H5::Group& f, std::size_t p,
+                                      std::size_t num_partitions,
+                                      Allocator&& alloc = Allocator{}) {
+  if (p >= num_partitions) {
+    throw std::out_of_range("read_partition: partition out of range.");
+  }
+  auto boundaries = partition_rows(f, num_partitions);
+  auto matrix =
+      read_csr_rows<T, I, P>(f, boundaries[p], boundaries[p + 1], alloc);
+  return {matrix, boundaries[p], boundaries[p + 1]};
+}
+
+template <typename T, typename I, typename P = I,
+          typename Allocator = std::allocator<T>>
+csr_partition<T, I, P> read_partition(std::string fname, std::size_t p,
+                                      std::size_t num_partitions,
+                                      Allocator&& alloc = Allocator{}) {
+  auto f = hdf5_tools::open_read_only(fname);
+  return read_partition<T, I, P>(f, p, num_partitions, alloc);
+}
+
+/// Precompute nnz-balanced row partitions of the CSR matrix `m`, already
+/// written to `f`, for each count in `partition_counts`.  The boundaries are
+/// stored in the datasets `row_partitions_<P>` and the counts are listed under
+/// the metadata key "row_partitions", so that `partition_rows` and
+/// `read_partition` need not read the row pointers.
+template <typename T, typename I, typename P>
+void write_row_partitions(H5::Group& f, csr_matrix<T, I, P> m,
+                          const std::vector<std::size_t>& partition_counts,
+                          const write_options& options = {}) {
+  auto metadata =
+      nlohmann::json::parse(hdf5_tools::get_attribute(f, "binsparse"));
+
+  for (auto&& num_partitions : partition_counts) {
+    auto&& stored = metadata["row_partitions"];
+    if (std::find(stored.begin(), stored.end(), num_partitions) !=
+        stored.end()) {
+      continue;
+    }
+
+    auto boundaries = __detail::balanced_row_partitions(
+        std::span<const P>(m.row_ptr, m.m + 1), num_partitions);
+    hdf5_tools::write_dataset(
+        f, __detail::row_partitions_label(num_partitions), boundaries,
+        options);
+    stored.push_back(num_partitions);
+  }
+
+  hdf5_tools::set_attribute(f, "binsparse", metadata.dump(2));
 }
 
 // CSC Format
 
-template <typename T, typename I>
-void write_csc_matrix(H5::Group& f, csc_matrix<T, I> m,
-                      nlohmann::json user_keys = {}) {
+template <typename T, typename I, typename P>
+void write_csc_matrix(H5::Group& f, csc_matrix<T, I, P> m,
+                      nlohmann::json user_keys = {},
+                      const write_options& options = {}) {
   std::span<T> values(m.values, m.nnz);
   std::span<I> rowind(m.rowind, m.nnz);
-  std::span<I> col_ptr(m.col_ptr, m.m + 1);
+  std::span<P> col_ptr(m.col_ptr, m.n + 1);
 
-  hdf5_tools::write_dataset(f, "values", values);
-  hdf5_tools::write_dataset(f, "indices_1", rowind);
-  hdf5_tools::write_dataset(f, "pointers_to_1", col_ptr);
+  hdf5_tools::write_dataset(f, "values", values, options);
+  auto rowind_type = __detail::write_index_dataset<I>(f, "indices_1", rowind,
+                                                      options);
+  auto col_ptr_type = __detail::write_index_dataset<P>(f, "pointers_to_1",
+                                                       col_ptr, options);
 
   using json = nlohmann::json;
   json j;
   j["binsparse"]["version"] = version;
-  j["binsparse"]["format"] = "CSR";
+  j["binsparse"]["format"] = "CSC";
   j["binsparse"]["shape"] = {m.m, m.n};
   j["binsparse"]["nnz"] = m.nnz;
-  j["binsparse"]["data_types"]["pointers_to_1"] = type_info<I>::label();
-  j["binsparse"]["data_types"]["indices_1"] = type_info<I>::label();
+  j["binsparse"]["data_types"]["pointers_to_1"] = col_ptr_type;
+  j["binsparse"]["data_types"]["indices_1"] = rowind_type;
   j["binsparse"]["data_types"]["values"] = type_info<T>::label();
 
   if (m.structure != general) {
@@ -249,25 +955,22 @@ void write_csc_matrix(H5::Group& f, csc_matrix<T, I> m,
   hdf5_tools::set_attribute(f, "binsparse", j.dump(2));
 }
 
-template <typename T, typename I>
-void write_csc_matrix(std::string fname, csc_matrix<T, I> m,
-                      nlohmann::json user_keys = {}) {
+template <typename T, typename I, typename P>
+void write_csc_matrix(std::string fname, csc_matrix<T, I, P> m,
+                      nlohmann::json user_keys = {},
+                      const write_options& options = {}) {
   H5::H5File f(fname.c_str(), H5F_ACC_TRUNC);
-  write_csc_matrix(f, m, user_keys);
+  write_csc_matrix(f, m, user_keys, options);
   f.close();
 }
 
-template <typename T, typename I, typename Allocator>
-csc_matrix<T, I> read_csc_matrix(std::string fname, Allocator&& alloc) {
-  H5::H5File f(fname.c_str(), H5F_ACC_RDWR);
-
-  auto metadata = hdf5_tools::get_attribute(f, "binsparse");
-
-  using json = nlohmann::json;
-  auto data = json::parse(metadata);
-
-  auto binsparse_metadata = data["binsparse"];
+namespace __detail {
 
+template <typename T, typename I, typename P, typename Source,
+          typename Allocator>
+csc_matrix<T, I, P>
+read_csc_matrix_impl(Source& f, const nlohmann::json& binsparse_metadata,
+                     Allocator&& alloc) {
   assert(binsparse_metadata["format"] == "CSC");
 
   auto nrows = binsparse_metadata["shape"][0];
@@ -278,9 +981,13 @@ csc_matrix<T, I> read_csc_matrix(std::string fname, Allocator&& alloc) {
       std::remove_cvref_t<Allocator>>::template rebind_alloc<I>
       i_alloc(alloc);
 
+  typename std::allocator_traits<
+      std::remove_cvref_t<Allocator>>::template rebind_alloc<P>
+      p_alloc(alloc);
+
   auto values = hdf5_tools::read_dataset<T>(f, "values", alloc);
   auto rowind = hdf5_tools::read_dataset<I>(f, "indices_1", i_alloc);
-  auto col_ptr = hdf5_tools::read_dataset<I>(f, "pointers_to_1", i_alloc);
+  auto col_ptr = hdf5_tools::read_dataset<P>(f, "pointers_to_1", p_alloc);
 
   structure_t structure = general;
 
@@ -288,36 +995,134 @@ csc_matrix<T, I> read_csc_matrix(std::string fname, Allocator&& alloc) {
     structure = __detail::parse_structure(binsparse_metadata["structure"]);
   }
 
-  return csc_matrix<T, I>{values.data(), rowind.data(), col_ptr.data(), nrows,
-                          ncols,         nnz,           structure};
+  return csc_matrix<T, I, P>{values.data(), rowind.data(), col_ptr.data(),
+                             nrows,         ncols,         nnz,
+                             structure};
 }
 
-template <typename T, typename I>
-csc_matrix<T, I> read_csc_matrix(std::string fname) {
-  return read_csc_matrix<T, I>(fname, std::allocator<T>{});
+} // namespace __detail
+
+/// Read the CSC matrix stored in `f`.  The column pointers are read as `P`,
+/// which may be wider than the index type `I`.
+template <typename T, typename I, typename P = I, typename Allocator>
+csc_matrix<T, I, P> read_csc_matrix(H5::Group& f, Allocator&& alloc) {
+  auto binsparse_metadata = __detail::read_binsparse_metadata(f);
+  return __detail::read_csc_matrix_impl<T, I, P>(f, binsparse_metadata,
+                                                 alloc);
 }
 
-// COO Format
+template <typename T, typename I, typename P = I, typename Allocator>
+csc_matrix<T, I, P> read_csc_matrix(std::string fname, Allocator&& alloc) {
+  auto f = hdf5_tools::open_read_only(fname);
+  return read_csc_matrix<T, I, P>(f, alloc);
+}
 
-template <typename T, typename I>
-void write_coo_matrix(H5::Group& f, coo_matrix<T, I> m,
-                      nlohmann::json user_keys = {}) {
-  std::span<T> values(m.values, m.nnz);
-  std::span<I> rowind(m.rowind, m.nnz);
-  std::span<I> colind(m.colind, m.nnz);
+template <typename T, typename I, typename P = I>
+csc_matrix<T, I, P> read_csc_matrix(H5::Group& f) {
+  return read_csc_matrix<T, I, P>(f, std::allocator<T>{});
+}
 
-  hdf5_tools::write_dataset(f, "values", values);
-  hdf5_tools::write_dataset(f, "indices_0", rowind);
-  hdf5_tools::write_dataset(f, "indices_1", colind);
+template <typename T, typename I, typename P = I>
+csc_matrix<T, I, P> read_csc_matrix(std::string fname) {
+  return read_csc_matrix<T, I, P>(fname, std::allocator<T>{});
+}
 
-  using json = nlohmann::json;
-  json j;
-  j["binsparse"]["version"] = version;
-  j["binsparse"]["format"] = "COO";
-  j["binsparse"]["shape"] = {m.m, m.n};
-  j["binsparse"]["nnz"] = m.nnz;
-  j["binsparse"]["data_types"]["indices_0"] = type_info<I>::label();
-  j["binsparse"]["data_types"]["indices_1"] = type_info<I>::label();
+namespace __detail {
+
+template <typename T, typename I, typename P, typename Source, typename VA,
+          typename IA, typename PA>
+csc_matrix<T, I, P> read_csc_matrix_into_impl(
+    Source& f, const nlohmann::json& binsparse_metadata,
+    std::vector<T, VA>& values, std::vector<I, IA>& rowind,
+    std::vector<P, PA>& col_ptr) {
+  assert(binsparse_metadata["format"] == "CSC");
+
+  I nrows = binsparse_metadata["shape"][0];
+  I ncols = binsparse_metadata["shape"][1];
+  P nnz = binsparse_metadata["nnz"];
+
+  hdf5_tools::read_dataset_into(f, "values", values);
+  hdf5_tools::read_dataset_into(f, "indices_1", rowind);
+  hdf5_tools::read_dataset_into(f, "pointers_to_1", col_ptr);
+
+  auto structure = __detail::read_structure(binsparse_metadata);
+
+  return csc_matrix<T, I, P>{values.data(), rowind.data(), col_ptr.data(),
+                             nrows,         ncols,         nnz,
+                             structure};
+}
+
+} // namespace __detail
+
+/// Read the CSC matrix stored in `f` into the vectors `values`, `rowind` and
+/// `col_ptr`, reusing their storage, and return a view of them.
+template <typename T, typename I, typename P, typename VA, typename IA,
+          typename PA>
+csc_matrix<T, I, P> read_csc_matrix_into(H5::Group& f,
+                                         std::vector<T, VA>& values,
+                                         std::vector<I, IA>& rowind,
+                                         std::vector<P, PA>& col_ptr) {
+  auto binsparse_metadata = __detail::read_binsparse_metadata(f);
+  return __detail::read_csc_matrix_into_impl(f, binsparse_metadata, values,
+                                             rowind, col_ptr);
+}
+
+template <typename T, typename I, typename P, typename VA, typename IA,
+          typename PA>
+csc_matrix<T, I, P> read_csc_matrix_into(std::string fname,
+                                         std::vector<T, VA>& values,
+                                         std::vector<I, IA>& rowind,
+                                         std::vector<P, PA>& col_ptr) {
+  auto f = hdf5_tools::open_read_only(fname);
+  return read_csc_matrix_into(f, values, rowind, col_ptr);
+}
+
+/// Read columns [col_begin, col_end) of the CSC matrix stored in `f` as an
+/// `m` by `col_end - col_begin` CSC matrix.  Only the slices of the stored
+/// arrays that cover those columns are read.
+template <typename T, typename I, typename P = I,
+          typename Allocator = std::allocator<T>>
+csc_matrix<T, I, P> read_csc_cols(H5::Group& f, std::size_t col_begin,
+                                  std::size_t col_end,
+                                  Allocator&& alloc = Allocator{}) {
+  auto binsparse_metadata = __detail::read_binsparse_metadata(f);
+  return __detail::read_csc_cols_impl<T, I, P>(f, binsparse_metadata, col_begin,
+                                               col_end, alloc);
+}
+
+template <typename T, typename I, typename P = I,
+          typename Allocator = std::allocator<T>>
+csc_matrix<T, I, P> read_csc_cols(std::string fname, std::size_t col_begin,
+                                  std::size_t col_end,
+                                  Allocator&& alloc = Allocator{}) {
+  auto f = hdf5_tools::open_read_only(fname);
+  return read_csc_cols<T, I, P>(f, col_begin, col_end, alloc);
+}
+
+// COO Format
+
+template <typename T, typename I>
+void write_coo_matrix(H5::Group& f, coo_matrix<T, I> m,
+                      nlohmann::json user_keys = {},
+                      const write_options& options = {}) {
+  std::span<T> values(m.values, m.nnz);
+  std::span<I> rowind(m.rowind, m.nnz);
+  std::span<I> colind(m.colind, m.nnz);
+
+  hdf5_tools::write_dataset(f, "values", values, options);
+  auto rowind_type = __detail::write_index_dataset<I>(f, "indices_0", rowind,
+                                                      options);
+  auto colind_type = __detail::write_index_dataset<I>(f, "indices_1", colind,
+                                                      options);
+
+  using json = nlohmann::json;
+  json j;
+  j["binsparse"]["version"] = version;
+  j["binsparse"]["format"] = "COO";
+  j["binsparse"]["shape"] = {m.m, m.n};
+  j["binsparse"]["nnz"] = m.nnz;
+  j["binsparse"]["data_types"]["indices_0"] = rowind_type;
+  j["binsparse"]["data_types"]["indices_1"] = colind_type;
   j["binsparse"]["data_types"]["values"] = type_info<T>::label();
 
   if (m.structure != general) {
@@ -334,23 +1139,88 @@ void write_coo_matrix(H5::Group& f, coo_matrix<T, I> m,
 
 template <typename T, typename I>
 void write_coo_matrix(std::string fname, coo_matrix<T, I> m,
-                      nlohmann::json user_keys = {}) {
+                      nlohmann::json user_keys = {},
+                      const write_options& options = {}) {
   H5::H5File f(fname.c_str(), H5F_ACC_TRUNC);
-  write_coo_matrix(f, m, user_keys);
+  write_coo_matrix(f, m, user_keys, options);
   f.close();
 }
 
-template <typename T, typename I, typename Allocator>
-coo_matrix<T, I> read_coo_matrix(std::string fname, Allocator&& alloc) {
-  H5::H5File f(fname.c_str(), H5F_ACC_RDWR);
+/// Write an `m` by `n` COO matrix whose stored values are the elements of
+/// `entries`, an input range such as a generator or an edge list, without
+/// first copying it into arrays.  The projections `row`, `col` and `value`
+/// return an entry's row, column and value; by default entries are
+/// tuple-like `(row, column, value)`.  Only one chunk of each array is held
+/// in memory.
+template <std::ranges::input_range R, typename I,
+          typename RowProj = __detail::get_element<0>,
+          typename ColProj = __detail::get_element<1>,
+          typename ValueProj = __detail::get_element<2>>
+void write_coo_matrix(H5::Group& f, R&& entries, I m, I n,
+                      nlohmann::json user_keys = {},
+                      const write_options& options = {}, RowProj row = {},
+                      ColProj col = {}, ValueProj value = {}) {
+  using T = std::remove_cvref_t<
+      std::invoke_result_t<ValueProj&, std::ranges::range_reference_t<R>>>;
+
+  auto size = __detail::known_size(entries);
+  hdf5_tools::dataset_appender<T> values(f, "values", options, size);
+  hdf5_tools::dataset_appender<I> rowind(f, "indices_0", options, size);
+  hdf5_tools::dataset_appender<I> colind(f, "indices_1", options, size);
+
+  for (auto&& entry : entries) {
+    std::size_t i = std::invoke(row, entry);
+    std::size_t j = std::invoke(col, entry);
+    if (i >= std::size_t(m) || j >= std::size_t(n)) {
+      throw std::out_of_range("write_coo_matrix: index out of bounds.");
+    }
+    rowind.push_back(I(i));
+    colind.push_back(I(j));
+    values.push_back(T(std::invoke(value, entry)));
+  }
 
-  auto metadata = hdf5_tools::get_attribute(f, "binsparse");
+  std::size_t nnz = values.size();
+  values.close();
+  rowind.close();
+  colind.close();
 
   using json = nlohmann::json;
-  auto data = json::parse(metadata);
+  json j;
+  j["binsparse"]["version"] = version;
+  j["binsparse"]["format"] = "COO";
+  j["binsparse"]["shape"] = {m, n};
+  j["binsparse"]["nnz"] = nnz;
+  j["binsparse"]["data_types"]["indices_0"] = type_info<I>::label();
+  j["binsparse"]["data_types"]["indices_1"] = type_info<I>::label();
+  j["binsparse"]["data_types"]["values"] = type_info<T>::label();
 
-  auto binsparse_metadata = data["binsparse"];
+  for (auto&& v : user_keys.items()) {
+    j[v.key()] = v.value();
+  }
+
+  hdf5_tools::set_attribute(f, "binsparse", j.dump(2));
+}
+
+template <std::ranges::input_range R, typename I,
+          typename RowProj = __detail::get_element<0>,
+          typename ColProj = __detail::get_element<1>,
+          typename ValueProj = __detail::get_element<2>>
+void write_coo_matrix(std::string fname, R&& entries, I m, I n,
+                      nlohmann::json user_keys = {},
+                      const write_options& options = {}, RowProj row = {},
+                      ColProj col = {}, ValueProj value = {}) {
+  H5::H5File f(fname.c_str(), H5F_ACC_TRUNC);
+  write_coo_matrix(f, std::forward<R>(entries), m, n, user_keys, options, row,
+                   col, value);
+  f.close();
+}
+
+namespace __detail {
 
+template <typename T, typename I, typename Source, typename Allocator>
+coo_matrix<T, I> read_coo_matrix_impl(Source& f,
+                                      const nlohmann::json& binsparse_metadata,
+                                      Allocator&& alloc) {
   auto format = __detail::unalias_format(binsparse_metadata["format"]);
 
   assert(format == "COOR" || format == "COOC");
@@ -377,13 +1247,773 @@ coo_matrix<T, I> read_coo_matrix(std::string fname, Allocator&& alloc) {
                           ncols,         nnz,         structure};
 }
 
+} // namespace __detail
+
+template <typename T, typename I, typename Allocator>
+coo_matrix<T, I> read_coo_matrix(H5::Group& f, Allocator&& alloc) {
+  auto binsparse_metadata = __detail::read_binsparse_metadata(f);
+  return __detail::read_coo_matrix_impl<T, I>(f, binsparse_metadata, alloc);
+}
+
+template <typename T, typename I, typename Allocator>
+coo_matrix<T, I> read_coo_matrix(std::string fname, Allocator&& alloc) {
+  auto f = hdf5_tools::open_read_only(fname);
+  return read_coo_matrix<T, I>(f, alloc);
+}
+
+template <typename T, typename I>
+coo_matrix<T, I> read_coo_matrix(H5::Group& f) {
+  return read_coo_matrix<T, I>(f, std::allocator<T>{});
+}
+
 template <typename T, typename I>
 coo_matrix<T, I> read_coo_matrix(std::string fname) {
   return read_coo_matrix<T, I>(fname, std::allocator<T>{});
 }
 
-inline auto inspect(std::string fname) {
+namespace __detail {
+
+template <typename T, typename I, typename Source, typename VA, typename IA>
+coo_matrix<T, I> read_coo_matrix_into_impl(
+    Source& f, const nlohmann::json& binsparse_metadata,
+    std::vector<T, VA>& values, std::vector<I, IA>& rowind,
+    std::vector<I, IA>& colind) {
+  auto format = __detail::unalias_format(binsparse_metadata["format"]);
+
+  assert(format == "COOR" || format == "COOC");
+
+  I nrows = binsparse_metadata["shape"][0];
+  I ncols = binsparse_metadata["shape"][1];
+  I nnz = binsparse_metadata["nnz"];
+
+  hdf5_tools::read_dataset_into(f, "values", values);
+  hdf5_tools::read_dataset_into(f, "indices_0", rowind);
+  hdf5_tools::read_dataset_into(f, "indices_1", colind);
+
+  auto structure = __detail::read_structure(binsparse_metadata);
+
+  return coo_matrix<T, I>{values.data(), rowind.data(), colind.data(), nrows,
+                          ncols,         nnz,           structure};
+}
+
+} // namespace __detail
+
+/// Read the COO matrix stored in `f` into the vectors `values`, `rowind` and
+/// `colind`, reusing their storage, and return a view of them.
+template <typename T, typename I, typename VA, typename IA>
+coo_matrix<T, I> read_coo_matrix_into(H5::Group& f, std::vector<T, VA>& values,
+                                      std::vector<I, IA>& rowind,
+                                      std::vector<I, IA>& colind) {
+  auto binsparse_metadata = __detail::read_binsparse_metadata(f);
+  return __detail::read_coo_matrix_into_impl(f, binsparse_metadata, values,
+                                             rowind, colind);
+}
+
+template <typename T, typename I, typename VA, typename IA>
+coo_matrix<T, I> read_coo_matrix_into(std::string fname,
+                                      std::vector<T, VA>& values,
+                                      std::vector<I, IA>& rowind,
+                                      std::vector<I, IA>& colind) {
+  auto f = hdf5_tools::open_read_only(fname);
+  return read_coo_matrix_into(f, values, rowind, colind);
+}
+
+/// Write a sparse row index for the COO matrix `m`, already written to `f`.
+/// The index records the offset of the first entry of every
+/// `rows_per_block`-th row in the dataset `row_index`, and its block size
+/// under the metadata key "row_index", so that `read_coo_rows` can locate a
+/// range of rows without scanning `indices_0`.  The entries of `m` must be
+/// sorted by row.
+template <typename T, typename I>
+void write_coo_row_index(H5::Group& f, coo_matrix<T, I> m,
+                         std::size_t rows_per_block = 1024,
+                         const write_options& options = {}) {
+  if (rows_per_block == 0) {
+    throw std::invalid_argument("write_coo_row_index: empty row blocks.");
+  }
+
+  std::span<I> rowind(m.rowind, m.nnz);
+  if (!std::ranges::is_sorted(rowind)) {
+    throw std::invalid_argument(
+        "write_coo_row_index: entries are not sorted by row.");
+  }
+
+  std::size_t num_blocks = (std::size_t(m.m) + rows_per_block - 1) /
+                           rows_per_block;
+
+  std::vector<std::uint64_t> offsets(num_blocks + 1);
+  for (std::size_t b = 0; b <= num_blocks; b++) {
+    std::size_t row = std::min<std::size_t>(b * rows_per_block, m.m);
+    offsets[b] = std::ranges::lower_bound(rowind, row) - rowind.begin();
+  }
+
+  hdf5_tools::write_dataset(f, "row_index", offsets, options);
+
+  auto metadata =
+      nlohmann::json::parse(hdf5_tools::get_attribute(f, "binsparse"));
+  metadata["row_index"]["rows_per_block"] = rows_per_block;
+  hdf5_tools::set_attribute(f, "binsparse", metadata.dump(2));
+}
+
+namespace __detail {
+
+// Returns the first position in [first, last) of the sorted row indices in
+// `rowind` holding a row of at least `row`.  Every read of a chunked dataset
+// decompresses a whole chunk, so the search probes only the first element
+// of each chunk, then searches the one chunk holding the bound in memory.
+template <typename I>
+std::size_t lower_bound_in_dataset(H5::DataSet& rowind, std::size_t first,
+                                   std::size_t last, std::size_t row) {
+  hsize_t chunk = 1;
+  auto property_list = rowind.getCreatePlist();
+  if (property_list.getLayout() == H5D_CHUNKED) {
+    property_list.getChunk(1, &chunk);
+  }
+
+  // Find the first chunk after the one holding `first` that starts with a
+  // row of at least `row`.  The bound lies in the chunk before it.
+  std::size_t low = first / chunk + 1;
+  std::size_t high = (last + chunk - 1) / chunk;
+  while (low < high) {
+    std::size_t mid = low + (high - low) / 2;
+    I value;
+    hdf5_tools::read_dataset(rowind, mid * chunk, 1, &value);
+    if (std::size_t(value) < row) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  std::size_t begin = std::max<std::size_t>(first, (low - 1) * chunk);
+  std::size_t end = std::min<std::size_t>(last, low * chunk);
+  std::vector<I> rows(end - begin);
+  hdf5_tools::read_dataset(rowind, begin, rows.size(), rows.data());
+  return begin + (std::ranges::lower_bound(
+                      rows, row, {},
+                      [](I value) { return std::size_t(value); }) -
+                  rows.begin());
+}
+
+template <typename T, typename I, typename Source, typename Allocator>
+coo_matrix<T, I> read_coo_rows_impl(Source& f, const nlohmann::json& metadata,
+                                    std::size_t row_begin, std::size_t row_end,
+                                    Allocator&& alloc) {
+  auto&& binsparse_metadata = metadata["binsparse"];
+
+  auto format = __detail::unalias_format(binsparse_metadata["format"]);
+
+  assert(format == "COOR");
+
+  std::size_t nrows = binsparse_metadata["shape"][0];
+  I ncols = binsparse_metadata["shape"][1];
+  std::size_t nnz = binsparse_metadata["nnz"];
+
+  if (row_begin > row_end || row_end > nrows) {
+    throw std::out_of_range("read_coo_rows: row range out of bounds.");
+  }
+
+  typename std::allocator_traits<
+      std::remove_cvref_t<Allocator>>::template rebind_alloc<I>
+      i_alloc(alloc);
+
+  auto rowind_dataset = f.openDataSet("indices_0");
+
+  std::size_t first;
+  std::size_t last;
+  I* rows;
+
+  if (metadata.contains("row_index")) {
+    // Read the entries of the index blocks covering the range, then find
+    // the exact range among them.
+    std::size_t rows_per_block = metadata["row_index"]["rows_per_block"];
+    std::size_t num_blocks = (nrows + rows_per_block - 1) / rows_per_block;
+
+    std::uint64_t lower;
+    std::uint64_t upper;
+    auto index_dataset = f.openDataSet("row_index");
+    hdf5_tools::read_dataset(index_dataset, row_begin / rows_per_block, 1,
+                             &lower);
+    hdf5_tools::read_dataset(
+        index_dataset,
+        std::min(num_blocks, (row_end + rows_per_block - 1) / rows_per_block),
+        1, &upper);
+
+    std::vector<I> block_rows(upper - lower);
+    hdf5_tools::read_dataset(rowind_dataset, lower, upper - lower,
+                             block_rows.data());
+
+    first = lower + (std::ranges::lower_bound(block_rows, row_begin) -
+                     block_rows.begin());
+    last = lower + (std::ranges::lower_bound(block_rows, row_end) -
+                    block_rows.begin());
+
+    rows = i_alloc.allocate(last - first);
+    std::copy(block_rows.begin() + (first - lower),
+              block_rows.begin() + (last - lower), rows);
+  } else {
+    // Without an index, binary search the stored row indices.
+    first = lower_bound_in_dataset<I>(rowind_dataset, 0, nnz, row_begin);
+    last = lower_bound_in_dataset<I>(rowind_dataset, first, nnz, row_end);
+
+    rows = i_alloc.allocate(last - first);
+    hdf5_tools::read_dataset(rowind_dataset, first, last - first, rows);
+  }
+
+  for (std::size_t k = 0; k < last - first; k++) {
+    rows[k] -= row_begin;
+  }
+
+  T* values = alloc.allocate(last - first);
+  auto values_dataset = f.openDataSet("values");
+  hdf5_tools::read_dataset(values_dataset, first, last - first, values);
+
+  I* cols = i_alloc.allocate(last - first);
+  auto colind_dataset = f.openDataSet("indices_1");
+  hdf5_tools::read_dataset(colind_dataset, first, last - first, cols);
+
+  structure_t structure = general;
+
+  if (binsparse_metadata.contains("structure")) {
+    structure = __detail::parse_structure(binsparse_metadata["structure"]);
+  }
+
+  return coo_matrix<T, I>{values, rows,  cols,           I(row_end - row_begin),
+                          ncols,  I(last - first), structure};
+}
+
+} // namespace __detail
+
+/// Read rows [row_begin, row_end) of the row-sorted COO matrix stored in `f`
+/// as a `row_end - row_begin` by `n` COO matrix, with row indices relative to
+/// `row_begin`.  The entries are located with the index written by
+/// `write_coo_row_index` when present, and otherwise by binary search of
+/// `indices_0`; only the entries in the range are read.
+template <typename T, typename I, typename Allocator = std::allocator<T>>
+coo_matrix<T, I> read_coo_rows(H5::Group& f, std::size_t row_begin,
+                               std::size_t row_end,
+                               Allocator&& alloc = Allocator{}) {
+  auto metadata =
+      nlohmann::json::parse(hdf5_tools::get_attribute(f, "binsparse"));
+  return __detail::read_coo_rows_impl<T, I>(f, metadata, row_begin, row_end,
+                                            alloc);
+}
+
+template <typename T, typename I, typename Allocator = std::allocator<T>>
+coo_matrix<T, I> read_coo_rows(std::string fname, std::size_t row_begin,
+                               std::size_t row_end,
+                               Allocator&& alloc = Allocator{}) {
+  auto f = hdf5_tools::open_read_only(fname);
+  return read_coo_rows<T, I>(f, row_begin, row_end, alloc);
+}
+
+// DCSR and DCSC Formats
+
+template <typename T, typename I, typename P>
+void write_dcsr_matrix(H5::Group& f, dcsr_matrix<T, I, P> m,
+                       nlohmann::json user_keys = {},
+                       const write_options& options = {}) {
+  std::span<T> values(m.values, m.nnz);
+  std::span<I> colind(m.colind, m.nnz);
+  std::span<P> row_ptr(m.row_ptr, m.stored_rows + 1);
+  std::span<I> rowind(m.rowind, m.stored_rows);
+
+  hdf5_tools::write_dataset(f, "values", values, options);
+  auto colind_type = __detail::write_index_dataset<I>(f, "indices_1", colind,
+                                                      options);
+  auto row_ptr_type = __detail::write_index_dataset<P>(f, "pointers_to_1",
+                                                       row_ptr, options);
+  auto rowind_type = __detail::write_index_dataset<I>(f, "indices_0", rowind,
+                                                      options);
+
+  using json = nlohmann::json;
+  json j;
+  j["binsparse"]["version"] = version;
+  j["binsparse"]["format"] = "DCSR";
+  j["binsparse"]["shape"] = {m.m, m.n};
+  j["binsparse"]["nnz"] = m.nnz;
+  j["binsparse"]["data_types"]["indices_0"] = rowind_type;
+  j["binsparse"]["data_types"]["pointers_to_1"] = row_ptr_type;
+  j["binsparse"]["data_types"]["indices_1"] = colind_type;
+  j["binsparse"]["data_types"]["values"] = type_info<T>::label();
+
+  if (m.structure != general) {
+    j["binsparse"]["structure"] =
+        __detail::get_structure_name(m.structure).value();
+  }
+
+  for (auto&& v : user_keys.items()) {
+    j[v.key()] = v.value();
+  }
+
+  hdf5_tools::set_attribute(f, "binsparse", j.dump(2));
+}
+
+template <typename T, typename I, typename P>
+void write_dcsr_matrix(std::string fname, dcsr_matrix<T, I, P> m,
+                       nlohmann::json user_keys = {},
+                       const write_options& options = {}) {
+  H5::H5File f(fname.c_str(), H5F_ACC_TRUNC);
+  write_dcsr_matrix(f, m, user_keys, options);
+  f.close();
+}
+
+template <typename T, typename I, typename P>
+void write_dcsc_matrix(H5::Group& f, dcsc_matrix<T, I, P> m,
+                       nlohmann::json user_keys = {},
+                       const write_options& options = {}) {
+  std::span<T> values(m.values, m.nnz);
+  std::span<I> rowind(m.rowind, m.nnz);
+  std::span<P> col_ptr(m.col_ptr, m.stored_cols + 1);
+  std::span<I> colind(m.colind, m.stored_cols);
+
+  hdf5_tools::write_dataset(f, "values", values, options);
+  auto rowind_type = __detail::write_index_dataset<I>(f, "indices_1", rowind,
+                                                      options);
+  auto col_ptr_type = __detail::write_index_dataset<P>(f, "pointers_to_1",
+                                                       col_ptr, options);
+  auto colind_type = __detail::write_index_dataset<I>(f, "indices_0", colind,
+                                                      options);
+
+  using json = nlohmann::json;
+  json j;
+  j["binsparse"]["version"] = version;
+  j["binsparse"]["format"] = "DCSC";
+  j["binsparse"]["shape"] = {m.m, m.n};
+  j["binsparse"]["nnz"] = m.nnz;
+  j["binsparse"]["data_types"]["indices_0"] = colind_type;
+  j["binsparse"]["data_types"]["pointers_to_1"] = col_ptr_type;
+  j["binsparse"]["data_types"]["indices_1"] = rowind_type;
+  j["binsparse"]["data_types"]["values"] = type_info<T>::label();
+
+  if (m.structure != general) {
+    j["binsparse"]["structure"] =
+        __detail::get_structure_name(m.structure).value();
+  }
+
+  for (auto&& v : user_keys.items()) {
+    j[v.key()] = v.value();
+  }
+
+  hdf5_tools::set_attribute(f, "binsparse", j.dump(2));
+}
+
+template <typename T, typename I, typename P>
+void write_dcsc_matrix(std::string fname, dcsc_matrix<T, I, P> m,
+                       nlohmann::json user_keys = {},
+                       const write_options& options = {}) {
+  H5::H5File f(fname.c_str(), H5F_ACC_TRUNC);
+  write_dcsc_matrix(f, m, user_keys, options);
+  f.close();
+}
+
+namespace __detail {
+
+template <typename T, typename I, typename P, typename Source,
+          typename Allocator>
+dcsr_matrix<T, I, P>
+read_dcsr_matrix_impl(Source& f, const nlohmann::json& binsparse_metadata,
+                      Allocator&& alloc) {
+  assert(binsparse_metadata["format"] == "DCSR");
+
+  auto nrows = binsparse_metadata["shape"][0];
+  auto ncols = binsparse_metadata["shape"][1];
+  auto nnz = binsparse_metadata["nnz"];
+
+  typename std::allocator_traits<
+      std::remove_cvref_t<Allocator>>::template rebind_alloc<I>
+      i_alloc(alloc);
+
+  typename std::allocator_traits<
+      std::remove_cvref_t<Allocator>>::template rebind_alloc<P>
+      p_alloc(alloc);
+
+  auto values = hdf5_tools::read_dataset<T>(f, "values", alloc);
+  auto colind = hdf5_tools::read_dataset<I>(f, "indices_1", i_alloc);
+  auto row_ptr = hdf5_tools::read_dataset<P>(f, "pointers_to_1", p_alloc);
+  auto rowind = hdf5_tools::read_dataset<I>(f, "indices_0", i_alloc);
+
+  auto structure = __detail::read_structure(binsparse_metadata);
+
+  return dcsr_matrix<T, I, P>{values.data(), colind.data(),    row_ptr.data(),
+                              rowind.data(), nrows,            ncols,
+                              nnz,           I(rowind.size()), structure};
+}
+
+template <typename T, typename I, typename P, typename Source,
+          typename Allocator>
+dcsc_matrix<T, I, P>
+read_dcsc_matrix_impl(Source& f, const nlohmann::json& binsparse_metadata,
+                      Allocator&& alloc) {
+  assert(binsparse_metadata["format"] == "DCSC");
+
+  auto nrows = binsparse_metadata["shape"][0];
+  auto ncols = binsparse_metadata["shape"][1];
+  auto nnz = binsparse_metadata["nnz"];
+
+  typename std::allocator_traits<
+      std::remove_cvref_t<Allocator>>::template rebind_alloc<I>
+      i_alloc(alloc);
+
+  typename std::allocator_traits<
+      std::remove_cvref_t<Allocator>>::template rebind_alloc<P>
+      p_alloc(alloc);
+
+  auto values = hdf5_tools::read_dataset<T>(f, "values", alloc);
+  auto rowind = hdf5_tools::read_dataset<I>(f, "indices_1", i_alloc);
+  auto col_ptr = hdf5_tools::read_dataset<P>(f, "pointers_to_1", p_alloc);
+  auto colind = hdf5_tools::read_dataset<I>(f, "indices_0", i_alloc);
+
+  auto structure = __detail::read_structure(binsparse_metadata);
+
+  return dcsc_matrix<T, I, P>{values.data(), rowind.data(),    col_ptr.data(),
+                              colind.data(), nrows,            ncols,
+                              nnz,           I(colind.size()), structure};
+}
+
+} // namespace __detail
+
+/// Read the DCSR matrix stored in `f`.
+template <typename T, typename I, typename P = I, typename Allocator>
+dcsr_matrix<T, I, P> read_dcsr_matrix(H5::Group& f, Allocator&& alloc) {
+  auto binsparse_metadata = __detail::read_binsparse_metadata(f);
+  return __detail::read_dcsr_matrix_impl<T, I, P>(f, binsparse_metadata,
+                                                  alloc);
+}
+
+template <typename T, typename I, typename P = I, typename Allocator>
+dcsr_matrix<T, I, P> read_dcsr_matrix(std::string fname, Allocator&& alloc) {
+  auto f = hdf5_tools::open_read_only(fname);
+  return read_dcsr_matrix<T, I, P>(f, alloc);
+}
+
+template <typename T, typename I, typename P = I>
+dcsr_matrix<T, I, P> read_dcsr_matrix(H5::Group& f) {
+  return read_dcsr_matrix<T, I, P>(f, std::allocator<T>{});
+}
+
+template <typename T, typename I, typename P = I>
+dcsr_matrix<T, I, P> read_dcsr_matrix(std::string fname) {
+  return read_dcsr_matrix<T, I, P>(fname, std::allocator<T>{});
+}
+
+/// Read the DCSC matrix stored in `f`.
+template <typename T, typename I, typename P = I, typename Allocator>
+dcsc_matrix<T, I, P> read_dcsc_matrix(H5::Group& f, Allocator&& alloc) {
+  auto binsparse_metadata = __detail::read_binsparse_metadata(f);
+  return __detail::read_dcsc_matrix_impl<T, I, P>(f, binsparse_metadata,
+                                                  alloc);
+}
+
+template <typename T, typename I, typename P = I, typename Allocator>
+dcsc_matrix<T, I, P> read_dcsc_matrix(std::string fname, Allocator&& alloc) {
+  auto f = hdf5_tools::open_read_only(fname);
+  return read_dcsc_matrix<T, I, P>(f, alloc);
+}
+
+template <typename T, typename I, typename P = I>
+dcsc_matrix<T, I, P> read_dcsc_matrix(H5::Group& f) {
+  return read_dcsc_matrix<T, I, P>(f, std::allocator<T>{});
+}
+
+template <typename T, typename I, typename P = I>
+dcsc_matrix<T, I, P> read_dcsc_matrix(std::string fname) {
+  return read_dcsc_matrix<T, I, P>(fname, std::allocator<T>{});
+}
+
+namespace __detail {
+
+// Number of threads, at most `num_threads`, worth using to convert the
+// pointers of `n` rows or columns.
+inline std::size_t conversion_threads(std::size_t n, std::size_t num_threads) {
+  constexpr std::size_t min_per_thread = 1 << 16;
+  return std::max<std::size_t>(1, std::min(num_threads, n / min_per_thread));
+}
+
+// Number of the `n` major rows or columns described by `ptr` that hold stored
+// values, counted by each of `num_threads` threads over its block.  Entry
+// `t + 1` of the result is the number of nonempty ones before the end of
+// block `t`.
+template <typename I, typename P>
+std::vector<std::size_t> count_nonempty(const P* ptr, I n,
+                                        std::size_t num_threads) {
+  std::vector<std::size_t> counts(num_threads + 1, 0);
+  parallel_for(num_threads, [&](std::size_t t) {
+    auto [first, last] = block_range(n, t, num_threads);
+    std::size_t count = 0;
+    for (std::size_t i = first; i < last; i++) {
+      count += ptr[i + 1] != ptr[i];
+    }
+    counts[t + 1] = count;
+  });
+
+  for (std::size_t t = 0; t < num_threads; t++) {
+    counts[t + 1] += counts[t];
+  }
+  return counts;
+}
+
+// Compress the `n + 1` pointers `ptr` into `indices`, the indices of the
+// nonempty rows or columns, and `compressed_ptr`, their pointers.  `counts`
+// is the result of `count_nonempty`.
+template <typename I, typename P>
+void compress_pointers(const P* ptr, I n, I* indices, P* compressed_ptr,
+                       const std::vector<std::size_t>& counts,
+                       std::size_t num_threads) {
+  parallel_for(num_threads, [&](std::size_t t) {
+    auto [first, last] = block_range(n, t, num_threads);
+    std::size_t k = counts[t];
+    for (std::size_t i = first; i < last; i++) {
+      if (ptr[i + 1] != ptr[i]) {
+        indices[k] = I(i);
+        compressed_ptr[k] = ptr[i];
+        k++;
+      }
+    }
+  });
+  compressed_ptr[counts[num_threads]] = ptr[n];
+}
+
+// Expand the pointers `compressed_ptr` of the `stored` rows or columns listed
+// in `indices` into `ptr`, the `n + 1` pointers of every row or column.  The
+// empty rows or columns before each stored one start where it does.
+template <typename I, typename P>
+void expand_pointers(const I* indices, const P* compressed_ptr, I stored,
+                     I n, P* ptr, std::size_t num_threads) {
+  parallel_for(num_threads, [&](std::size_t t) {
+    auto [first, last] = block_range(stored, t, num_threads);
+    for (std::size_t k = first; k < last; k++) {
+      std::size_t begin = k == 0 ? 0 : std::size_t(indices[k - 1]) + 1;
+      for (std::size_t i = begin; i <= std::size_t(indices[k]); i++) {
+        ptr[i] = compressed_ptr[k];
+      }
+    }
+  });
+
+  std::size_t begin = stored == 0 ? 0 : std::size_t(indices[stored - 1]) + 1;
+  for (std::size_t i = begin; i <= std::size_t(n); i++) {
+    ptr[i] = compressed_ptr[stored];
+  }
+}
+
+} // namespace __detail
+
+/// Convert the CSR matrix `m` to DCSR, dropping the pointers of its empty
+/// rows.  The result shares `m.values` and `m.colind`; only its row indices
+/// and row pointers are allocated, with `alloc` rebound to `I` and `P`.
+template <typename T, typename I, typename P,
+          typename Allocator = std::allocator<T>>
+dcsr_matrix<T, I, P>
+csr_to_dcsr(csr_matrix<T, I, P> m, Allocator&& alloc = Allocator{},
+            std::size_t num_threads = __detail::default_num_threads()) {
+  typename std::allocator_traits<
+      std::remove_cvref_t<Allocator>>::template rebind_alloc<I>
+      i_alloc(alloc);
+
+  typename std::allocator_traits<
+      std::remove_cvref_t<Allocator>>::template rebind_alloc<P>
+      p_alloc(alloc);
+
+  num_threads = __detail::conversion_threads(m.m, num_threads);
+  auto counts = __detail::count_nonempty(m.row_ptr, m.m, num_threads);
+  I stored_rows = I(counts[num_threads]);
+
+  I* rowind = i_alloc.allocate(stored_rows);
+  P* row_ptr = p_alloc.allocate(stored_rows + 1);
+  __detail::compress_pointers(m.row_ptr, m.m, rowind, row_ptr, counts,
+                              num_threads);
+
+  return dcsr_matrix<T, I, P>{m.values, m.colind, row_ptr,     rowind,
+                              m.m,      m.n,      m.nnz,       stored_rows,
+                              m.structure};
+}
+
+/// Convert the DCSR matrix `m` to CSR.  The result shares `m.values` and
+/// `m.colind`; only its row pointers are allocated, with `alloc` rebound to
+/// `P`.
+template <typename T, typename I, typename P,
+          typename Allocator = std::allocator<T>>
+csr_matrix<T, I, P>
+dcsr_to_csr(dcsr_matrix<T, I, P> m, Allocator&& alloc = Allocator{},
+            std::size_t num_threads = __detail::default_num_threads()) {
+  typename std::allocator_traits<
+      std::remove_cvref_t<Allocator>>::template rebind_alloc<P>
+      p_alloc(alloc);
+
+  num_threads = __detail::conversion_threads(m.m, num_threads);
+  P* row_ptr = p_alloc.allocate(std::size_t(m.m) + 1);
+  __detail::expand_pointers(m.rowind, m.row_ptr, m.stored_rows, m.m, row_ptr,
+                            num_threads);
+
+  return csr_matrix<T, I, P>{m.values, m.colind, row_ptr,
+                             m.m,      m.n,      m.nnz,   m.structure};
+}
+
+/// Convert the CSC matrix `m` to DCSC, dropping the pointers of its empty
+/// columns.  The result shares `m.values` and `m.rowind`.
+template <typename T, typename I, typename P,
+          typename Allocator = std::allocator<T>>
+dcsc_matrix<T, I, P>
+csc_to_dcsc(csc_matrix<T, I, P> m, Allocator&& alloc = Allocator{},
+            std::size_t num_threads = __detail::default_num_threads()) {
+  typename std::allocator_traits<
+      std::remove_cvref_t<Allocator>>::template rebind_alloc<I>
+      i_alloc(alloc);
+
+  typename std::allocator_traits<
+      std::remove_cvref_t<Allocator>>::template rebind_alloc<P>
+      p_alloc(alloc);
+
+  num_threads = __detail::conversion_threads(m.n, num_threads);
+  auto counts = __detail::count_nonempty(m.col_ptr, m.n, num_threads);
+  I stored_cols = I(counts[num_threads]);
+
+  I* colind = i_alloc.allocate(stored_cols);
+  P* col_ptr = p_alloc.allocate(stored_cols + 1);
+  __detail::compress_pointers(m.col_ptr, m.n, colind, col_ptr, counts,
+                              num_threads);
+
+  return dcsc_matrix<T, I, P>{m.values, m.rowind, col_ptr,     colind,
+                              m.m,      m.n,      m.nnz,       stored_cols,
+                              m.structure};
+}
+
+/// Convert the DCSC matrix `m` to CSC.  The result shares `m.values` and
+/// `m.rowind`.
+template <typename T, typename I, typename P,
+          typename Allocator = std::allocator<T>>
+csc_matrix<T, I, P>
+dcsc_to_csc(dcsc_matrix<T, I, P> m, Allocator&& alloc = Allocator{},
+            std::size_t num_threads = __detail::default_num_threads()) {
+  typename std::allocator_traits<
+      std::remove_cvref_t<Allocator>>::template rebind_alloc<P>
+      p_alloc(alloc);
+
+  num_threads = __detail::conversion_threads(m.n, num_threads);
+  P* col_ptr = p_alloc.allocate(std::size_t(m.n) + 1);
+  __detail::expand_pointers(m.colind, m.col_ptr, m.stored_cols, m.n, col_ptr,
+                            num_threads);
+
+  return csc_matrix<T, I, P>{m.values, m.rowind, col_ptr,
+                             m.m,      m.n,      m.nnz,   m.structure};
+}
+
+// Values Only
+
+namespace __detail {
+
+template <typename T, typename I, typename Order>
+std::span<T> stored_values(const dense_matrix<T, I, Order>& m) {
+  return std::span<T>(m.values, std::size_t(m.m) * std::size_t(m.n));
+}
+
+template <typename T, typename I, typename P>
+std::span<T> stored_values(const csr_matrix<T, I, P>& m) {
+  return std::span<T>(m.values, m.nnz);
+}
+
+template <typename T, typename I, typename P>
+std::span<T> stored_values(const csc_matrix<T, I, P>& m) {
+  return std::span<T>(m.values, m.nnz);
+}
+
+template <typename T, typename I>
+std::span<T> stored_values(const coo_matrix<T, I>& m) {
+  return std::span<T>(m.values, m.nnz);
+}
+
+template <typename T, typename I, typename P>
+std::span<T> stored_values(const dcsr_matrix<T, I, P>& m) {
+  return std::span<T>(m.values, m.nnz);
+}
+
+template <typename T, typename I, typename P>
+std::span<T> stored_values(const dcsc_matrix<T, I, P>& m) {
+  return std::span<T>(m.values, m.nnz);
+}
+
+// Throws `std::invalid_argument` unless the matrix described by
+// `binsparse_metadata` has the format, shape and number of stored values of
+// `m`, so that the two can differ only in their values.
+template <typename Matrix>
+void check_same_structure(const nlohmann::json& binsparse_metadata,
+                          const Matrix& m, const std::string& caller) {
+  auto format = unalias_format(binsparse_metadata["format"]);
+  if (format != get_matrix_format_string(m)) {
+    throw std::invalid_argument(caller + ": stored matrix has format " +
+                                format + ", not " +
+                                get_matrix_format_string(m) + ".");
+  }
+
+  std::size_t nrows = binsparse_metadata["shape"][0];
+  std::size_t ncols = binsparse_metadata["shape"][1];
+  std::size_t nnz = binsparse_metadata["nnz"];
+  if (nrows != std::size_t(m.m) || ncols != std::size_t(m.n) ||
+      nnz != stored_values(m).size()) {
+    throw std::invalid_argument(
+        caller + ": stored matrix differs in shape or number of values.");
+  }
+}
+
+template <typename Source, typename Matrix>
+void read_values_into_impl(Source& f, const nlohmann::json& binsparse_metadata,
+                           const Matrix& m, std::size_t num_threads) {
+  check_same_structure(binsparse_metadata, m, "read_values_into");
+
+  auto values = stored_values(m);
+  auto dataset = f.openDataSet("values");
+  hdf5_tools::read_dataset(dataset, 0, values.size(), values.data(),
+                           num_threads);
+}
+
+} // namespace __detail
+
+/// Overwrite the values of the matrix stored in `f` with the values of `m`,
+/// leaving its index arrays and metadata untouched.  The stored matrix must
+/// have the same format, shape and number of stored values as `m`, or
+/// `std::invalid_argument` is thrown.  For a matrix whose sparsity pattern is
+/// fixed, this writes only the values, a fraction of the whole matrix.
+template <typename Matrix>
+void update_values(H5::Group& f, const Matrix& m,
+                   std::size_t num_threads = __detail::default_num_threads()) {
+  auto binsparse_metadata = __detail::read_binsparse_metadata(f);
+  __detail::check_same_structure(binsparse_metadata, m, "update_values");
+
+  auto dataset = f.openDataSet("values");
+  hdf5_tools::write_dataset(dataset, 0, __detail::stored_values(m),
+                            num_threads);
+}
+
+template <typename Matrix>
+void update_values(std::string fname, const Matrix& m,
+                   std::size_t num_threads = __detail::default_num_threads()) {
   H5::H5File f(fname.c_str(), H5F_ACC_RDWR);
+  update_values(f, m, num_threads);
+  f.close();
+}
+
+/// Read only the values of the matrix stored in `f` into the values of `m`,
+/// an existing matrix with the same format, shape and number of stored
+/// values, for instance one read earlier from the same file.  The index
+/// arrays of `m` are left untouched.
+template <typename Matrix>
+void read_values_into(H5::Group& f, const Matrix& m,
+                      std::size_t num_threads =
+                          __detail::default_num_threads()) {
+  auto binsparse_metadata = __detail::read_binsparse_metadata(f);
+  __detail::read_values_into_impl(f, binsparse_metadata, m, num_threads);
+}
+
+template <typename Matrix>
+void read_values_into(std::string fname, const Matrix& m,
+                      std::size_t num_threads =
+                          __detail::default_num_threads()) {
+  auto f = hdf5_tools::open_read_only(fname);
+  read_values_into(f, m, num_threads);
+}
+
+inline auto inspect(std::string fname) {
+  auto f = hdf5_tools::open_read_only(fname);
 
   auto metadata = hdf5_tools::get_attribute(f, "binsparse");
 
@@ -8,7 +8,7 @@
 extern "C" {
 
 bc_matrix_struct bc_read_matrix(const char* fname) {
-  H5::H5File f(fname, H5F_ACC_RDWR);
+  auto f = hdf5_tools::open_read_only(fname);
 
   auto metadata = hdf5_tools::read_dataset<char>(f, "metadata");
 
@@ -20,10 +20,14 @@ bc_matrix_struct bc_read_matrix(const char* fname) {
   if (data["format"] == "COO") {
 
     auto value_type = hdf5_tools::dataset_type(f, "values");
-    auto index_type = hdf5_tools::dataset_type(f, "indices_0");
 
-    if (value_type == H5::PredType::IEEE_F32LE &&
-        index_type == H5::PredType::STD_U64LE) {
+    // Indices may be stored in any integer width; they are converted to 64
+    // bits as they are read.
+    auto index_dataset = f.openDataSet("indices_0");
+    bool integer_indices = index_dataset.getTypeClass() == H5T_INTEGER;
+    index_dataset.close();
+
+    if (value_type == H5::PredType::IEEE_F32LE && integer_indices) {
       using T = float;
       using I = uint64_t;
       auto matrix = binsparse::read_coo_matrix<T, I>(fname);
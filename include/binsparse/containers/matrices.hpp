@@ -26,23 +26,58 @@ struct column_major {
 
 enum structure_t { general, symmetric, skew_symmetric, hermitian };
 
-template <typename T, typename I>
+// The row pointers, and the number of stored values they count, have their
+// own type `P`, so that matrices with more stored values than `I` can count
+// need not widen their column indices as well.
+template <typename T, typename I, typename P = I>
 struct csr_matrix {
   T* values;
   I* colind;
-  I* row_ptr;
+  P* row_ptr;
 
-  I m, n, nnz;
+  I m, n;
+  P nnz;
   structure_t structure = general;
 };
 
-template <typename T, typename I>
+template <typename T, typename I, typename P = I>
 struct csc_matrix {
   T* values;
   I* rowind;
-  I* col_ptr;
+  P* col_ptr;
 
-  I m, n, nnz;
+  I m, n;
+  P nnz;
+  structure_t structure = general;
+};
+
+// A doubly compressed sparse row matrix, which stores pointers only for the
+// `stored_rows` rows holding values.  `rowind` lists those rows in increasing
+// order, and the values of row `rowind[r]` are stored at positions
+// [row_ptr[r], row_ptr[r + 1]).
+template <typename T, typename I, typename P = I>
+struct dcsr_matrix {
+  T* values;
+  I* colind;
+  P* row_ptr;
+  I* rowind;
+  I m, n;
+  P nnz;
+  I stored_rows;
+  structure_t structure = general;
+};
+
+// A doubly compressed sparse column matrix, the column-major counterpart of
+// `dcsr_matrix`.
+template <typename T, typename I, typename P = I>
+struct dcsc_matrix {
+  T* values;
+  I* rowind;
+  P* col_ptr;
+  I* colind;
+  I m, n;
+  P nnz;
+  I stored_cols;
   structure_t structure = general;
 };
 
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <binsparse/binsparse.hpp>
+#include <exception>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+namespace binsparse {
+
+/// Writes an `m` by `n` COO matrix in batches of entries, so that matrices
+/// arriving as a stream can be stored without holding them in memory.  The
+/// arrays are stored in chunked datasets with unlimited extent that grow with
+/// each batch, and each chunk is compressed and written once it is full.  The
+/// metadata, including the final number of stored values, is written by
+/// `close()`, which is also called when the appender is destroyed.  A
+/// destructor cannot report errors, so callers should call `close()` to
+/// handle them; a failed close in the destructor calls `std::terminate()`.
+template <typename T, typename I>
+class coo_appender {
+public:
+  /// Append to a new matrix stored in `f`.
+  coo_appender(H5::Group f, I m, I n, nlohmann::json user_keys = {},
+               const write_options& options = {})
+      : f_(std::move(f)), m_(m), n_(n), user_keys_(std::move(user_keys)),
+        values_(f_, "values", options), rowind_(f_, "indices_0", options),
+        colind_(f_, "indices_1", options) {}
+
+  /// Append to a new matrix stored in the file `fname`, replacing any
+  /// existing file.
+  coo_appender(const std::string& fname, I m, I n,
+               nlohmann::json user_keys = {},
+               const write_options& options = {})
+      : coo_appender(H5::H5File(fname.c_str(), H5F_ACC_TRUNC).openGroup("/"),
+                     m, n, std::move(user_keys), options) {}
+
+  coo_appender(const coo_appender&) = delete;
+  coo_appender& operator=(const coo_appender&) = delete;
+
+  ~coo_appender() {
+    try {
+      close();
+    } catch (...) {
+      // Failures while unwinding from another exception are a consequence of
+      // it; any other failure leaves an incomplete file nobody was told of.
+      if (std::uncaught_exceptions() == 0) {
+        std::terminate();
+      }
+    }
+  }
+
+  /// Append the entries `(rows[k], cols[k], values[k])`.
+  void append(std::span<const I> rows, std::span<const I> cols,
+              std::span<const T> values) {
+    if (closed_) {
+      throw std::runtime_error("coo_appender: append after close.");
+    }
+
+    if (rows.size() != values.size() || cols.size() != values.size()) {
+      throw std::invalid_argument("coo_appender: batch arrays differ in size.");
+    }
+
+    for (std::size_t k = 0; k < values.size(); k++) {
+      if (std::size_t(rows[k]) >= std::size_t(m_) ||
+          std::size_t(cols[k]) >= std::size_t(n_)) {
+        throw std::out_of_range("coo_appender: index out of bounds.");
+      }
+    }
+
+    values_.append(values);
+    rowind_.append(rows);
+    colind_.append(cols);
+  }
+
+  /// Number of entries appended so far.
+  std::size_t size() const {
+    return values_.size();
+  }
+
+  /// Write any buffered entries and the metadata.  No entries may be
+  /// appended afterwards.  Call this explicitly to see errors as exceptions.
+  void close() {
+    if (closed_) {
+      return;
+    }
+    closed_ = true;
+
+    values_.close();
+    rowind_.close();
+    colind_.close();
+
+    using json = nlohmann::json;
+    json j;
+    j["binsparse"]["version"] = version;
+    j["binsparse"]["format"] = "COO";
+    j["binsparse"]["shape"] = {m_, n_};
+    j["binsparse"]["nnz"] = values_.size();
+    j["binsparse"]["data_types"]["indices_0"] = type_info<I>::label();
+    j["binsparse"]["data_types"]["indices_1"] = type_info<I>::label();
+    j["binsparse"]["data_types"]["values"] = type_info<T>::label();
+
+    for (auto&& v : user_keys_.items()) {
+      j[v.key()] = v.value();
+    }
+
+    hdf5_tools::set_attribute(f_, "binsparse", j.dump(2));
+    f_.close();
+  }
+
+private:
+  H5::Group f_;
+  I m_;
+  I n_;
+  nlohmann::json user_keys_;
+
+  hdf5_tools::dataset_appender<T> values_;
+  hdf5_tools::dataset_appender<I> rowind_;
+  hdf5_tools::dataset_appender<I> colind_;
+
+  bool closed_ = false;
+};
+
+} // namespace binsparse
@@ -17,6 +17,31 @@ get_matrix_format_string(dense_matrix<T, I, column_major> m) {
   return "DMATC";
 }
 
+template <typename T, typename I, typename P>
+inline std::string get_matrix_format_string(csr_matrix<T, I, P>) {
+  return "CSR";
+}
+
+template <typename T, typename I, typename P>
+inline std::string get_matrix_format_string(csc_matrix<T, I, P>) {
+  return "CSC";
+}
+
+template <typename T, typename I, typename P>
+inline std::string get_matrix_format_string(dcsr_matrix<T, I, P>) {
+  return "DCSR";
+}
+
+template <typename T, typename I, typename P>
+inline std::string get_matrix_format_string(dcsc_matrix<T, I, P>) {
+  return "DCSC";
+}
+
+template <typename T, typename I>
+inline std::string get_matrix_format_string(coo_matrix<T, I> m) {
+  return "COOR";
+}
+
 inline std::string unalias_format(const std::string& format) {
   if (format == "DMAT") {
     return "DMATR";
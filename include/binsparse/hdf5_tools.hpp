@@ -1,11 +1,28 @@
 #pragma once
 
 #include <H5Cpp.h>
+#include <algorithm>
+#include <atomic>
+#include <binsparse/parallel.hpp>
+#include <bit>
 #include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <optional>
 #include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
+#if H5_VERSION_GE(1, 10, 5) && __has_include(<zlib.h>)
+#define BINSPARSE_HAS_DIRECT_CHUNK_IO 1
+#include <zlib.h>
+#endif
+
 #include <iostream>
 
 namespace hdf5_tools {
@@ -15,6 +32,8 @@ inline H5::PredType get_hdf5_native_type() {
   using T = std::decay_t<U>;
   if constexpr (std::is_same_v<T, char>) {
     return H5::PredType::NATIVE_CHAR;
+  } else if constexpr (std::is_same_v<T, signed char>) {
+    return H5::PredType::NATIVE_SCHAR;
   } else if constexpr (std::is_same_v<T, unsigned char>) {
     return H5::PredType::NATIVE_UCHAR;
   } else if constexpr (std::is_same_v<T, short>) {
@@ -78,65 +97,783 @@ inline H5::PredType get_hdf5_standard_type() {
   }
 }
 
-inline H5::PredType get_type(H5::DataSet& dataset) {
+// Whether files opened with `open_read_only` take HDF5's advisory file lock.
+inline std::atomic<bool> use_file_locking = true;
+
+// Open `file_name` read-only.  Any number of processes may do so at once.
+// When `use_file_locking` is false, no file lock is taken at all, which also
+// allows reading from file systems that do not support locking.  This requires
+// HDF5 1.10.7; older versions honor the `HDF5_USE_FILE_LOCKING` environment
+// variable instead.
+inline H5::H5File open_read_only(const std::string& file_name) {
+  H5::FileAccPropList access_properties;
+#if H5_VERSION_GE(1, 10, 7)
+  if (!use_file_locking) {
+    H5Pset_file_locking(access_properties.getId(), false, true);
+  }
+#endif
+  return H5::H5File(file_name.c_str(), H5F_ACC_RDONLY,
+                    H5::FileCreatPropList::DEFAULT, access_properties);
+}
+
+namespace __detail {
+
+// The representation of a dataset's elements, for datasets stored in a
+// little-endian integer or IEEE floating-point type.
+struct element_type {
+  bool is_float;
+  bool is_signed;
+  std::size_t size;
+
+  // Whether the elements are stored in the representation of `U`.
+  template <typename U>
+  bool is() const {
+    return is_float == std::is_floating_point_v<U> &&
+           is_signed == std::is_signed_v<U> && size == sizeof(U);
+  }
+};
+
+inline std::optional<element_type> get_element_type(H5::DataSet& dataset) {
   H5T_class_t type_class = dataset.getTypeClass();
+  H5std_string order_string;
 
   if (type_class == H5T_INTEGER) {
     H5::IntType intype = dataset.getIntType();
+    if (intype.getOrder(order_string) == H5T_ORDER_LE) {
+      return element_type{false, intype.getSign() == H5T_SGN_2,
+                          intype.getSize()};
+    }
+  } else if (type_class == H5T_FLOAT) {
+    H5::FloatType floatype = dataset.getFloatType();
+    if (floatype.getOrder(order_string) == H5T_ORDER_LE) {
+      return element_type{true, true, floatype.getSize()};
+    }
+  }
+  return {};
+}
+
+} // namespace __detail
+
+// The standard type in which `dataset` is stored: any little-endian integer
+// type from 8 to 64 bits, or a 32 or 64-bit IEEE float.
+inline H5::PredType get_type(H5::DataSet& dataset) {
+  auto type = __detail::get_element_type(dataset);
+
+  if (!type.has_value()) {
+    throw std::runtime_error("get_type: unsupported dataset type.");
+  } else if (type->is<std::uint8_t>()) {
+    return H5::PredType::STD_U8LE;
+  } else if (type->is<std::uint16_t>()) {
+    return H5::PredType::STD_U16LE;
+  } else if (type->is<std::uint32_t>()) {
+    return H5::PredType::STD_U32LE;
+  } else if (type->is<std::uint64_t>()) {
+    return H5::PredType::STD_U64LE;
+  } else if (type->is<std::int8_t>()) {
+    return H5::PredType::STD_I8LE;
+  } else if (type->is<std::int16_t>()) {
+    return H5::PredType::STD_I16LE;
+  } else if (type->is<std::int32_t>()) {
+    return H5::PredType::STD_I32LE;
+  } else if (type->is<std::int64_t>()) {
+    return H5::PredType::STD_I64LE;
+  } else if (type->is<float>()) {
+    return H5::PredType::IEEE_F32LE;
+  } else if (type->is<double>()) {
+    return H5::PredType::IEEE_F64LE;
+  } else {
+    throw std::runtime_error("get_type: unsupported dataset type.");
+  }
+}
 
-    H5std_string order_string;
-    H5T_order_t order = intype.getOrder(order_string);
+// HDF5 cannot store chunks of 4 GiB or more.
+inline constexpr std::size_t max_chunk_bytes = (std::size_t(1) << 32) - 1;
 
-    assert(order == H5T_ORDER_LE);
+// Storage layout of a dataset.
+enum class layout_t { chunked, contiguous };
 
-    size_t size = intype.getSize();
+// Options controlling how datasets are stored by `write_dataset` and
+// `create_dataset`.
+struct write_options {
+  // Chunked datasets may be compressed; contiguous datasets are stored
+  // uncompressed in a single block of the file.
+  layout_t layout = layout_t::chunked;
 
-    if (intype.getSign() == H5T_SGN_NONE && size == sizeof(std::uint64_t)) {
-      return H5::PredType::STD_U64LE;
-    } else if (intype.getSign() == H5T_SGN_2 && size == sizeof(std::int64_t)) {
-      return H5::PredType::STD_I64LE;
-    } else {
-      assert(false);
+  // Number of elements per chunk.  When zero, the chunk size is derived from
+  // `chunk_bytes` instead.
+  hsize_t chunk_elements = 0;
+
+  // Approximate number of bytes per chunk, used when `chunk_elements` is zero.
+  std::size_t chunk_bytes = std::size_t(1) << 20;
+
+  // Deflate compression level from 1 to 9, or 0 for no compression.
+  int deflate_level = 1;
+
+  // Apply the byte shuffle filter before compressing.
+  bool shuffle = true;
+
+  // Number of threads used to compress chunks.
+  std::size_t num_threads = binsparse::__detail::default_num_threads();
+
+  // Store index arrays in the smallest unsigned integer type that holds
+  // their largest element, rather than in the caller's index type.
+  bool narrow_indices = true;
+
+  // Options for uncompressed, contiguous datasets.
+  static write_options uncompressed() {
+    write_options options;
+    options.layout = layout_t::contiguous;
+    options.deflate_level = 0;
+    options.shuffle = false;
+    // Arrays stored in the caller's types can be mapped without conversion.
+    options.narrow_indices = false;
+    return options;
+  }
+
+  // Number of elements per chunk for a dataset of `size` elements of type `T`.
+  // The result is clamped below `max_chunk_bytes`, so arrays of any size are
+  // split into chunks HDF5 can store.
+  template <typename T>
+  hsize_t chunk_size(hsize_t size) const {
+    hsize_t chunk = chunk_elements;
+    if (chunk == 0) {
+      chunk = chunk_bytes / sizeof(T);
     }
-  } else if (type_class == H5T_FLOAT) {
-    H5::FloatType floatype = dataset.getFloatType();
+    chunk = std::min<hsize_t>(chunk, max_chunk_bytes / sizeof(T));
+    return std::max<hsize_t>(1, std::min(chunk, size));
+  }
 
-    H5std_string order_string;
-    H5T_order_t order = floatype.getOrder(order_string);
+  bool compressed() const {
+    return layout == layout_t::chunked && (deflate_level > 0 || shuffle);
+  }
+};
+
+// Dataset creation properties for a dataset of `size` elements of type `T`
+// stored according to `options`.  Empty datasets cannot be chunked, so they
+// are always contiguous.
+template <typename T>
+H5::DSetCreatPropList dataset_properties(hsize_t size,
+                                         const write_options& options) {
+  H5::DSetCreatPropList property_list;
 
-    assert(order == H5T_ORDER_LE);
+  if (options.layout == layout_t::contiguous || size == 0) {
+    property_list.setLayout(H5D_CONTIGUOUS);
+    return property_list;
+  }
 
-    size_t size = floatype.getSize();
+  hsize_t chunk = options.chunk_size<T>(size);
+  property_list.setChunk(1, &chunk);
 
-    if (size == sizeof(float)) {
-      return H5::PredType::IEEE_F32LE;
-    } else if (size == sizeof(double)) {
-      return H5::PredType::IEEE_F64LE;
-    } else {
-      assert(false);
+  if (options.shuffle) {
+    property_list.setShuffle();
+  }
+
+  if (options.deflate_level > 0) {
+    property_list.setDeflate(options.deflate_level);
+  }
+
+  return property_list;
+}
+
+// Create a one-dimensional dataset of `size` elements of type `T` whose
+// contents are written later, in pieces, with `write_dataset(dataset, offset,
+// r)`.  With a chunked layout only one chunk at a time needs to be held in
+// memory while writing.
+template <typename T, typename H5GroupOrFile>
+H5::DataSet create_dataset(H5GroupOrFile& f, const std::string& label,
+                           hsize_t size, const write_options& options = {}) {
+  H5::DataSpace dataspace(1, &size);
+
+  auto property_list = dataset_properties<T>(size, options);
+
+  return f.createDataSet(label.c_str(), get_hdf5_standard_type<T>(), dataspace,
+                         property_list);
+}
+
+// Create an empty one-dimensional dataset of elements of type `T` that grows
+// without bound as elements are added with `append_dataset`.  Extendible
+// datasets must be chunked, so a contiguous layout in `options` is ignored.
+template <typename T, typename H5GroupOrFile>
+H5::DataSet create_extendible_dataset(H5GroupOrFile& f,
+                                      const std::string& label,
+                                      const write_options& options = {}) {
+  hsize_t size = 0;
+  hsize_t max_size = H5S_UNLIMITED;
+  H5::DataSpace dataspace(1, &size, &max_size);
+
+  auto chunked_options = options;
+  chunked_options.layout = layout_t::chunked;
+  auto property_list = dataset_properties<T>(max_size, chunked_options);
+
+  return f.createDataSet(label.c_str(), get_hdf5_standard_type<T>(), dataspace,
+                         property_list);
+}
+
+namespace __detail {
+
+// The filters applied to each chunk of a dataset, when they are ones we can
+// apply ourselves.
+struct chunk_encoding {
+  hsize_t chunk_size;
+  bool shuffle;
+  bool deflate;
+  int deflate_level;
+};
+
+// Returns the encoding of `dataset`'s chunks if chunks of elements of type `T`
+// can be encoded and decoded here and accessed with `H5Dwrite_chunk` and
+// `H5Dread_chunk`: the dataset must be chunked, compressed with only shuffle
+// and/or deflate (in that order), and stored in the native representation of
+// `T`.
+template <typename T>
+std::optional<chunk_encoding> direct_chunk_encoding(H5::DataSet& dataset) {
+#ifdef BINSPARSE_HAS_DIRECT_CHUNK_IO
+  if constexpr (std::endian::native != std::endian::little ||
+                std::is_same_v<T, bool>) {
+    return {};
+  } else {
+    if (!(dataset.getDataType() == get_hdf5_standard_type<T>())) {
+      return {};
+    }
+
+    auto property_list = dataset.getCreatePlist();
+    if (property_list.getLayout() != H5D_CHUNKED) {
+      return {};
+    }
+
+    chunk_encoding encoding{0, false, false, 0};
+    property_list.getChunk(1, &encoding.chunk_size);
+
+    int nfilters = property_list.getNfilters();
+    if (nfilters == 0) {
+      return {};
+    }
+
+    for (int i = 0; i < nfilters; i++) {
+      unsigned int flags;
+      unsigned int filter_config;
+      unsigned int cd_values[8];
+      std::size_t cd_nelmts = 8;
+      char name[64];
+
+      auto filter = property_list.getFilter(i, flags, cd_nelmts, cd_values,
+                                            sizeof(name), name, filter_config);
+
+      if (filter == H5Z_FILTER_SHUFFLE && i == 0) {
+        encoding.shuffle = true;
+      } else if (filter == H5Z_FILTER_DEFLATE && i == nfilters - 1 &&
+                 cd_nelmts >= 1) {
+        encoding.deflate = true;
+        encoding.deflate_level = cd_values[0];
+      } else {
+        return {};
+      }
+    }
+
+    return encoding;
+  }
+#else
+  return {};
+#endif
+}
+
+#ifdef BINSPARSE_HAS_DIRECT_CHUNK_IO
+// Encode `count` elements of `element_size` bytes starting at `data` into
+// `out` exactly as HDF5's filter pipeline would for one chunk of
+// `encoding.chunk_size` elements.  A partial edge chunk is zero-padded to the
+// full chunk size.  `scratch` is reused between calls.
+template <std::size_t element_size>
+void encode_chunk(const unsigned char* data, std::size_t count,
+                  const chunk_encoding& encoding,
+                  std::vector<unsigned char>& scratch,
+                  std::vector<unsigned char>& out) {
+  std::size_t chunk_elements = encoding.chunk_size;
+  std::size_t chunk_bytes = chunk_elements * element_size;
+
+  const unsigned char* input = data;
+
+  if (encoding.shuffle && element_size > 1) {
+    scratch.assign(chunk_bytes, 0);
+    for (std::size_t b = 0; b < element_size; b++) {
+      for (std::size_t i = 0; i < count; i++) {
+        scratch[b * chunk_elements + i] = data[i * element_size + b];
+      }
+    }
+    input = scratch.data();
+  } else if (count < chunk_elements) {
+    scratch.assign(chunk_bytes, 0);
+    std::memcpy(scratch.data(), data, count * element_size);
+    input = scratch.data();
+  }
+
+  if (encoding.deflate) {
+    uLongf size = compressBound(chunk_bytes);
+    out.resize(size);
+    if (compress2(out.data(), &size, input, chunk_bytes,
+                  encoding.deflate_level) != Z_OK) {
+      throw std::runtime_error("write_dataset: failed to compress chunk.");
     }
+    out.resize(size);
   } else {
-    assert(false);
+    out.assign(input, input + chunk_bytes);
+  }
+}
+
+// Decode the stored chunk `raw`, encoded with `encoding` except for the
+// filters skipped according to `filter_mask`, and copy its elements
+// [first, first + count) to `out`.  `scratch` is reused between calls.
+template <std::size_t element_size>
+void decode_chunk(const std::vector<unsigned char>& raw,
+                  unsigned int filter_mask, std::size_t first,
+                  std::size_t count, const chunk_encoding& encoding,
+                  std::vector<unsigned char>& scratch, unsigned char* out) {
+  std::size_t chunk_elements = encoding.chunk_size;
+  std::size_t chunk_bytes = chunk_elements * element_size;
+
+  bool shuffled = encoding.shuffle && element_size > 1 && !(filter_mask & 1);
+  bool deflated = encoding.deflate &&
+                  !(filter_mask & (1u << (encoding.shuffle ? 1 : 0)));
+
+  const unsigned char* input = raw.data();
+
+  if (deflated) {
+    // A whole unshuffled chunk is inflated straight into the output.
+    bool whole = !shuffled && first == 0 && count == chunk_elements;
+    unsigned char* dest = out;
+    if (!whole) {
+      scratch.resize(chunk_bytes);
+      dest = scratch.data();
+    }
+
+    uLongf size = chunk_bytes;
+    if (uncompress(dest, &size, raw.data(), raw.size()) != Z_OK ||
+        size != chunk_bytes) {
+      throw std::runtime_error("read_dataset: failed to decompress chunk.");
+    }
+
+    if (whole) {
+      return;
+    }
+    input = scratch.data();
+  } else if (raw.size() != chunk_bytes) {
+    throw std::runtime_error("read_dataset: unexpected chunk size.");
+  }
+
+  if (shuffled) {
+    for (std::size_t b = 0; b < element_size; b++) {
+      for (std::size_t i = 0; i < count; i++) {
+        out[i * element_size + b] = input[b * chunk_elements + first + i];
+      }
+    }
+  } else {
+    std::memcpy(out, input + first * element_size, count * element_size);
+  }
+}
+#endif
+
+// Write `count` elements starting at element `offset` of `dataset`, whose
+// chunks are encoded with `encoding`, compressing chunks on `num_threads`
+// threads and writing the encoded chunks with `H5Dwrite_chunk`.  `offset`
+// must be the start of a chunk, and the range must end on a chunk boundary or
+// at the end of the dataset.
+template <typename T>
+void write_chunks_direct(H5::DataSet& dataset, hsize_t offset, const T* data,
+                         hsize_t count, const chunk_encoding& encoding,
+                         std::size_t num_threads) {
+#ifdef BINSPARSE_HAS_DIRECT_CHUNK_IO
+  hsize_t chunk = encoding.chunk_size;
+  std::size_t n_chunks = (count + chunk - 1) / chunk;
+
+  num_threads = std::max<std::size_t>(1, std::min(num_threads, n_chunks));
+
+  // Chunks are encoded in batches so that only a bounded number of encoded
+  // chunks are held in memory at once.
+  std::size_t batch_size = 4 * num_threads;
+  std::vector<std::vector<unsigned char>> encoded(batch_size);
+  std::vector<std::vector<unsigned char>> scratch(num_threads);
+
+  auto bytes = reinterpret_cast<const unsigned char*>(data);
+
+  for (std::size_t first = 0; first < n_chunks; first += batch_size) {
+    std::size_t batch = std::min(batch_size, n_chunks - first);
+
+    binsparse::__detail::parallel_for(num_threads, [&](std::size_t t) {
+      auto [begin, end] =
+          binsparse::__detail::block_range(batch, t, num_threads);
+      for (std::size_t c = begin; c < end; c++) {
+        hsize_t start = (first + c) * chunk;
+        hsize_t size = std::min(chunk, count - start);
+        encode_chunk<sizeof(T)>(bytes + start * sizeof(T), size, encoding,
+                                scratch[t], encoded[c]);
+      }
+    });
+
+    for (std::size_t c = 0; c < batch; c++) {
+      hsize_t chunk_offset = offset + (first + c) * chunk;
+      if (H5Dwrite_chunk(dataset.getId(), H5P_DEFAULT, 0, &chunk_offset,
+                         encoded[c].size(), encoded[c].data()) < 0) {
+        throw std::runtime_error("write_dataset: failed to write chunk.");
+      }
+    }
+  }
+#else
+  assert(false);
+#endif
+}
+
+// Read `count` elements starting at element `offset` of `dataset`, whose
+// chunks are encoded with `encoding`, into `data`.  The stored chunks are
+// read with `H5Dread_chunk` and decoded on `num_threads` threads.  Returns
+// false, having read nothing, if some chunk in the range is not allocated.
+template <typename T>
+bool read_chunks_direct(H5::DataSet& dataset, hsize_t offset, T* data,
+                        hsize_t count, const chunk_encoding& encoding,
+                        std::size_t num_threads) {
+#ifdef BINSPARSE_HAS_DIRECT_CHUNK_IO
+  hsize_t chunk = encoding.chunk_size;
+  hsize_t first_chunk = offset / chunk;
+  std::size_t n_chunks = (offset + count + chunk - 1) / chunk - first_chunk;
+
+  std::vector<hsize_t> sizes(n_chunks);
+  for (std::size_t c = 0; c < n_chunks; c++) {
+    hsize_t chunk_offset = (first_chunk + c) * chunk;
+    unsigned int filter_mask;
+    haddr_t address;
+    if (H5Dget_chunk_info_by_coord(dataset.getId(), &chunk_offset,
+                                   &filter_mask, &address, &sizes[c]) < 0 ||
+        address == HADDR_UNDEF) {
+      return false;
+    }
+  }
+
+  num_threads = std::max<std::size_t>(1, std::min(num_threads, n_chunks));
+
+  // Chunks are read in batches so that only a bounded number of stored
+  // chunks are held in memory at once.
+  std::size_t batch_size = 4 * num_threads;
+  std::vector<std::vector<unsigned char>> stored(batch_size);
+  std::vector<std::uint32_t> filter_masks(batch_size);
+  std::vector<std::vector<unsigned char>> scratch(num_threads);
+
+  auto bytes = reinterpret_cast<unsigned char*>(data);
+
+  for (std::size_t first = 0; first < n_chunks; first += batch_size) {
+    std::size_t batch = std::min(batch_size, n_chunks - first);
+
+    for (std::size_t c = 0; c < batch; c++) {
+      hsize_t chunk_offset = (first_chunk + first + c) * chunk;
+      stored[c].resize(sizes[first + c]);
+      if (H5Dread_chunk(dataset.getId(), H5P_DEFAULT, &chunk_offset,
+                        &filter_masks[c], stored[c].data()) < 0) {
+        throw std::runtime_error("read_dataset: failed to read chunk.");
+      }
+    }
+
+    binsparse::__detail::parallel_for(num_threads, [&](std::size_t t) {
+      auto [begin, end] =
+          binsparse::__detail::block_range(batch, t, num_threads);
+      for (std::size_t c = begin; c < end; c++) {
+        hsize_t chunk_start = (first_chunk + first + c) * chunk;
+        hsize_t start = std::max(chunk_start, offset);
+        hsize_t stop = std::min(chunk_start + chunk, offset + count);
+        decode_chunk<sizeof(T)>(stored[c], filter_masks[c],
+                                start - chunk_start, stop - start, encoding,
+                                scratch[t],
+                                bytes + (start - offset) * sizeof(T));
+      }
+    });
+  }
+
+  return true;
+#else
+  return false;
+#endif
+}
+
+} // namespace __detail
+
+// Read `count` elements starting at element `offset` of `dataset` into
+// `data`.  For datasets compressed with shuffle and/or deflate, the stored
+// chunks are read directly and decompressed on `num_threads` threads,
+// bypassing HDF5's serial filter pipeline.  Datasets stored in any other
+// integer or floating-point type are converted to `T` as they are read, and
+// `std::out_of_range` is thrown if a stored value does not fit in `T`.
+template <typename T>
+void read_dataset(H5::DataSet& dataset, hsize_t offset, hsize_t count,
+                  T* data,
+                  std::size_t num_threads =
+                      binsparse::__detail::default_num_threads());
+
+namespace __detail {
+
+// Whether each of the `count` values at `values` can be represented as a
+// `T`: integers must lie in the range of `T`, and floating-point values read
+// as integers must also be whole numbers.  Conversions to floating point
+// round, as HDF5's do.  The loops carry no branches, so they vectorize.
+template <typename T, typename U>
+bool representable(const U* values, std::size_t count) {
+  if constexpr (std::is_floating_point_v<T>) {
+    return true;
+  } else if constexpr (std::is_floating_point_v<U>) {
+    // Both bounds are powers of two, and so exact in `U`.
+    const U upper = std::ldexp(U(1), std::numeric_limits<T>::digits);
+    const U lower = std::is_signed_v<T> ? -upper : U(0);
+    bool in_range = true;
+    for (std::size_t k = 0; k < count; k++) {
+      U value = values[k];
+      in_range &= (value >= lower) & (value < upper) &
+                  (value == std::trunc(value));
+    }
+    return in_range;
+  } else if constexpr (std::in_range<T>(std::numeric_limits<U>::min()) &&
+                       std::in_range<T>(std::numeric_limits<U>::max())) {
+    return true;
+  } else {
+    U min = std::numeric_limits<U>::max();
+    U max = std::numeric_limits<U>::min();
+    for (std::size_t k = 0; k < count; k++) {
+      min = std::min(min, values[k]);
+      max = std::max(max, values[k]);
+    }
+    return count == 0 || (std::in_range<T>(min) && std::in_range<T>(max));
+  }
+}
+
+// Read `count` elements starting at element `offset` of `dataset`, which
+// stores elements of type `U`, into `data`, converting them to `T` here
+// rather than in HDF5's conversion path.  The elements are read through a
+// buffer in blocks of whole chunks, enough for every thread to decompress
+// one, and each block is converted while it is still in cache.  Throws
+// `std::out_of_range` if some value cannot be represented as a `T`.
+template <typename U, typename T>
+void read_converted(H5::DataSet& dataset, hsize_t offset, hsize_t count,
+                    T* data, std::size_t num_threads) {
+  hsize_t block = hsize_t(1) << 16;
+  auto property_list = dataset.getCreatePlist();
+  if (property_list.getLayout() == H5D_CHUNKED) {
+    hsize_t chunk;
+    property_list.getChunk(1, &chunk);
+    block = std::max<hsize_t>(block, chunk * num_threads);
+    block = (block + chunk - 1) / chunk * chunk;
+  }
+
+  std::vector<U> stored(std::min(block, count));
+  for (hsize_t first = 0; first < count;) {
+    hsize_t n = std::min(block - (offset + first) % block, count - first);
+    read_dataset(dataset, offset + first, n, stored.data(), num_threads);
+    if (!representable<T>(stored.data(), n)) {
+      throw std::out_of_range("read_dataset: stored value cannot be "
+                              "represented in the requested type.");
+    }
+    for (hsize_t k = 0; k < n; k++) {
+      data[first + k] = T(stored[k]);
+    }
+    first += n;
+  }
+}
+
+} // namespace __detail
+
+template <typename T>
+void read_dataset(H5::DataSet& dataset, hsize_t offset, hsize_t count,
+                  T* data, std::size_t num_threads) {
+  if (count == 0) {
+    return;
+  }
+
+  if (auto encoding = __detail::direct_chunk_encoding<T>(dataset)) {
+    if (__detail::read_chunks_direct(dataset, offset, data, count, *encoding,
+                                     num_threads)) {
+      return;
+    }
+  }
+
+  if constexpr (std::is_arithmetic_v<T> && !std::is_same_v<T, bool> &&
+                !std::is_same_v<T, char>) {
+    auto stored = __detail::get_element_type(dataset);
+    if (stored.has_value() && !stored->is<T>()) {
+      auto read_as = [&]<typename U>(U) {
+        if (stored->is<U>()) {
+          __detail::read_converted<U>(dataset, offset, count, data,
+                                      num_threads);
+          return true;
+        }
+        return false;
+      };
+      if (read_as(std::uint8_t()) || read_as(std::uint16_t()) ||
+          read_as(std::uint32_t()) || read_as(std::uint64_t()) ||
+          read_as(std::int8_t()) || read_as(std::int16_t()) ||
+          read_as(std::int32_t()) || read_as(std::int64_t()) ||
+          read_as(float()) || read_as(double())) {
+        return;
+      }
+    }
+  }
+
+  H5::DataSpace file_space = dataset.getSpace();
+  file_space.selectHyperslab(H5S_SELECT_SET, &count, &offset);
+
+  H5::DataSpace memory_space(1, &count);
+
+  dataset.read(data, get_hdf5_native_type<T>(), memory_space, file_space);
+}
+
+// Write the elements of `r` into `dataset`, starting at element `offset`.
+// When whole chunks of a compressed dataset are written, the chunks are
+// compressed on `num_threads` threads and written directly, bypassing HDF5's
+// serial filter pipeline.  The resulting file is identical in format.
+template <std::ranges::contiguous_range R>
+void write_dataset(H5::DataSet& dataset, hsize_t offset, R&& r,
+                   std::size_t num_threads =
+                       binsparse::__detail::default_num_threads()) {
+  using T = std::ranges::range_value_t<R>;
+  hsize_t count = std::ranges::size(r);
+
+  if (count == 0) {
+    return;
+  }
+
+  H5::DataSpace file_space = dataset.getSpace();
+
+  if (auto encoding = __detail::direct_chunk_encoding<T>(dataset)) {
+    hsize_t size;
+    file_space.getSimpleExtentDims(&size);
+    hsize_t chunk = encoding->chunk_size;
+
+    if (offset % chunk == 0 &&
+        (count % chunk == 0 || offset + count == size)) {
+      __detail::write_chunks_direct(dataset, offset, std::ranges::data(r),
+                                    count, *encoding, num_threads);
+      return;
+    }
   }
+
+  file_space.selectHyperslab(H5S_SELECT_SET, &count, &offset);
+
+  H5::DataSpace memory_space(1, &count);
+
+  dataset.write(std::ranges::data(r), get_hdf5_native_type<T>(), memory_space,
+                file_space);
+}
+
+// Extend the dataset `dataset`, created with `create_extendible_dataset`, by
+// the elements of `r`.
+template <std::ranges::contiguous_range R>
+void append_dataset(H5::DataSet& dataset, R&& r,
+                    std::size_t num_threads =
+                        binsparse::__detail::default_num_threads()) {
+  hsize_t size;
+  dataset.getSpace().getSimpleExtentDims(&size);
+
+  hsize_t new_size = size + std::ranges::size(r);
+  dataset.extend(&new_size);
+
+  write_dataset(dataset, size, r, num_threads);
 }
 
+// Writes the one-dimensional dataset `label` element by element or in
+// batches of any size.  Elements are buffered until a whole chunk can be
+// written, so memory use is bounded by the chunk size and every chunk is
+// compressed and written once.  When the final size is known the dataset is
+// created with that size, otherwise it is extendible and grows as elements
+// are written.
+template <typename T>
+class dataset_appender {
+public:
+  template <typename H5GroupOrFile>
+  dataset_appender(H5GroupOrFile& f, const std::string& label,
+                   const write_options& options = {},
+                   std::optional<hsize_t> size = {})
+      : size_(size), num_threads_(options.num_threads) {
+    if (size.has_value()) {
+      dataset_ = create_dataset<T>(f, label, *size, options);
+    } else {
+      dataset_ = create_extendible_dataset<T>(f, label, options);
+    }
+    capacity_ = options.chunk_size<T>(size.value_or(H5S_UNLIMITED));
+    stage_.reserve(capacity_);
+  }
+
+  void push_back(const T& value) {
+    stage_.push_back(value);
+    if (stage_.size() == capacity_) {
+      flush();
+    }
+  }
+
+  void append(std::span<const T> values) {
+    std::size_t k = 0;
+    while (k < values.size()) {
+      if (stage_.empty() && values.size() - k >= capacity_) {
+        // Whole chunks are written straight from `values`.
+        std::size_t count = (values.size() - k) / capacity_ * capacity_;
+        write(values.subspan(k, count));
+        k += count;
+      } else {
+        std::size_t count =
+            std::min(capacity_ - stage_.size(), values.size() - k);
+        stage_.insert(stage_.end(), values.begin() + k,
+                      values.begin() + k + count);
+        k += count;
+        if (stage_.size() == capacity_) {
+          flush();
+        }
+      }
+    }
+  }
+
+  // Number of elements appended so far.
+  hsize_t size() const {
+    return written_ + stage_.size();
+  }
+
+  // Write any buffered elements.
+  void flush() {
+    write(stage_);
+    stage_.clear();
+  }
+
+  void close() {
+    flush();
+    if (size_.has_value() && written_ != *size_) {
+      throw std::runtime_error("dataset_appender: wrote " +
+                               std::to_string(written_) + " of " +
+                               std::to_string(*size_) + " elements.");
+    }
+    dataset_.close();
+  }
+
+private:
+  void write(std::span<const T> values) {
+    if (size_.has_value()) {
+      if (written_ + values.size() > *size_) {
+        throw std::runtime_error("dataset_appender: dataset is full.");
+      }
+      write_dataset(dataset_, written_, values, num_threads_);
+    } else {
+      append_dataset(dataset_, values, num_threads_);
+    }
+    written_ += values.size();
+  }
+
+  H5::DataSet dataset_;
+  std::optional<hsize_t> size_;
+  std::size_t num_threads_;
+  std::size_t capacity_;
+  std::vector<T> stage_;
+  hsize_t written_ = 0;
+};
+
 template <typename H5GroupOrFile, std::ranges::contiguous_range R>
   requires(!std::is_same_v<std::remove_cvref_t<R>, std::string>)
-void write_dataset(H5GroupOrFile& f, const std::string& label, R&& r) {
+void write_dataset(H5GroupOrFile& f, const std::string& label, R&& r,
+                   const write_options& options = {}) {
   using T = std::ranges::range_value_t<R>;
   hsize_t size = std::ranges::size(r);
-  H5::DataSpace dataspace(1, &size);
-
-  H5::DSetCreatPropList property_list;
-  property_list.setChunk(1, &size);
-  property_list.setDeflate(9);
 
-  auto dataset = f.createDataSet(label.c_str(), get_hdf5_standard_type<T>(),
-                                 dataspace, property_list);
-
-  dataset.write(std::ranges::data(r), get_hdf5_native_type<T>());
+  auto dataset = create_dataset<T>(f, label, size, options);
+  write_dataset(dataset, 0, r, options.num_threads);
   dataset.close();
-  dataspace.close();
 }
 
 template <typename H5GroupOrFile, std::ranges::contiguous_range R>
@@ -170,8 +907,14 @@ inline std::string get_attribute(H5::H5Object& f, const std::string& key) {
   return attribute_string;
 }
 
+// Set the string attribute `key` of `f` to `value`, replacing any existing
+// attribute with the same name.
 inline void set_attribute(H5::H5Object& f, const std::string& key,
                           const std::string& value) {
+  if (f.attrExists(key.c_str())) {
+    f.removeAttr(key.c_str());
+  }
+
   H5::StrType string_type(H5::PredType::C_S1, value.size());
   string_type.setCset(H5T_CSET_UTF8);
   hsize_t size = value.size();
@@ -196,7 +939,7 @@ std::span<T> read_dataset(H5GroupOrFile& f, const std::string& label,
   space.close();
 
   T* data = alloc.allocate(dims);
-  dataset.read(data, get_hdf5_native_type<T>());
+  read_dataset(dataset, 0, dims, data);
   dataset.close();
   return std::span<T>(data, dims);
 }
@@ -206,6 +949,27 @@ std::span<T> read_dataset(H5GroupOrFile& f, const std::string& label) {
   return read_dataset<T>(f, label, std::allocator<T>{});
 }
 
+// Read the dataset `label` into `data`, resizing it to the dataset's size.
+// The vector's storage is reused, so it is only reallocated when the dataset
+// has grown beyond its capacity.
+template <typename T, typename A, typename H5GroupOrFile>
+std::span<T> read_dataset_into(H5GroupOrFile& f, const std::string& label,
+                               std::vector<T, A>& data) {
+  H5::DataSet dataset = f.openDataSet(label.c_str());
+
+  H5::DataSpace space = dataset.getSpace();
+  hsize_t ndims = space.getSimpleExtentNdims();
+  assert(ndims == 1);
+  hsize_t dims;
+  space.getSimpleExtentDims(&dims, &ndims);
+  space.close();
+
+  data.resize(dims);
+  read_dataset(dataset, 0, dims, data.data());
+  dataset.close();
+  return std::span<T>(data.data(), dims);
+}
+
 template <typename H5GroupOrFile>
 inline H5::PredType dataset_type(H5GroupOrFile& f, const std::string& label) {
   H5::DataSet dataset = f.openDataSet(label.c_str());
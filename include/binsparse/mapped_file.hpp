@@ -0,0 +1,180 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BINSPARSE_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <vector>
+#endif
+
+namespace binsparse {
+
+namespace __detail {
+
+// A view of a file's contents.  On POSIX systems the file is memory-mapped, so
+// the contents are never copied into user space; elsewhere the file is read
+// into an internal buffer.
+class mapped_file {
+public:
+  mapped_file() = default;
+
+  // Map the whole file read-only.
+  explicit mapped_file(const std::string& file_path) {
+    map(file_path, 0, std::string::npos, false);
+  }
+
+  // Map `length` bytes of the file starting at byte `offset`.  The mapping is
+  // private and writable: writes are visible only through this mapping and
+  // are never written back to the file.
+  mapped_file(const std::string& file_path, std::size_t offset,
+              std::size_t length) {
+    map(file_path, offset, length, true);
+  }
+
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  mapped_file(mapped_file&& other) noexcept {
+    *this = std::move(other);
+  }
+
+  mapped_file& operator=(mapped_file&& other) noexcept {
+    if (this != &other) {
+      unmap();
+      base_ = std::exchange(other.base_, nullptr);
+      base_size_ = std::exchange(other.base_size_, 0);
+      data_ = std::exchange(other.data_, nullptr);
+      size_ = std::exchange(other.size_, 0);
+#ifndef BINSPARSE_HAS_MMAP
+      buffer_ = std::move(other.buffer_);
+#endif
+    }
+    return *this;
+  }
+
+  ~mapped_file() {
+    unmap();
+  }
+
+  // Hint to the OS that the mapping will be read front to back.
+  void advise_sequential() const {
+#ifdef BINSPARSE_HAS_MMAP
+    if (base_ != nullptr) {
+      ::madvise(base_, base_size_, MADV_SEQUENTIAL);
+    }
+#endif
+  }
+
+  const char* data() const {
+    return data_;
+  }
+
+  // Only mappings of a byte range may be written to.
+  char* data() {
+    return data_;
+  }
+
+  std::size_t size() const {
+    return size_;
+  }
+
+  std::string_view view() const {
+    return std::string_view(data_, size_);
+  }
+
+private:
+  void map(const std::string& file_path, std::size_t offset,
+           std::size_t length, bool writable) {
+#ifdef BINSPARSE_HAS_MMAP
+    int fd = ::open(file_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("mapped_file: cannot open " + file_path);
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      ::close(fd);
+      throw std::runtime_error("mapped_file: cannot stat " + file_path);
+    }
+
+    std::size_t file_size = st.st_size;
+    if (offset > file_size ||
+        (length != std::string::npos && length > file_size - offset)) {
+      ::close(fd);
+      throw std::runtime_error("mapped_file: range out of bounds in " +
+                               file_path);
+    }
+
+    size_ = length == std::string::npos ? file_size - offset : length;
+
+    if (size_ > 0) {
+      // mmap offsets must be page-aligned.
+      std::size_t page = ::sysconf(_SC_PAGESIZE);
+      std::size_t delta = offset % page;
+      base_size_ = size_ + delta;
+
+      int protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+      void* ptr = ::mmap(nullptr, base_size_, protection, MAP_PRIVATE, fd,
+                         offset - delta);
+      if (ptr == MAP_FAILED) {
+        ::close(fd);
+        throw std::runtime_error("mapped_file: cannot map " + file_path);
+      }
+      base_ = ptr;
+      data_ = static_cast<char*>(ptr) + delta;
+    }
+
+    ::close(fd);
+#else
+    std::ifstream f(file_path, std::ios::binary | std::ios::ate);
+    if (!f.is_open()) {
+      throw std::runtime_error("mapped_file: cannot open " + file_path);
+    }
+    std::size_t file_size = f.tellg();
+    if (offset > file_size ||
+        (length != std::string::npos && length > file_size - offset)) {
+      throw std::runtime_error("mapped_file: range out of bounds in " +
+                               file_path);
+    }
+    buffer_.resize(length == std::string::npos ? file_size - offset : length);
+    f.seekg(offset);
+    f.read(buffer_.data(), buffer_.size());
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+#endif
+  }
+
+  void unmap() {
+#ifdef BINSPARSE_HAS_MMAP
+    if (base_ != nullptr) {
+      ::munmap(base_, base_size_);
+    }
+#endif
+    base_ = nullptr;
+    base_size_ = 0;
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+  void* base_ = nullptr;
+  std::size_t base_size_ = 0;
+  char* data_ = nullptr;
+  std::size_t size_ = 0;
+#ifndef BINSPARSE_HAS_MMAP
+  std::vector<char> buffer_;
+#endif
+};
+
+} // namespace __detail
+
+} // namespace binsparse
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <binsparse/binsparse.hpp>
+#include <binsparse/mapped_file.hpp>
+#include <bit>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace binsparse {
+
+namespace __detail {
+
+// Keeps alive the memory behind datasets read by `map_dataset`: either a
+// private mapping of the dataset's bytes in the file, or a buffer holding a
+// copy for datasets that cannot be mapped.
+class mapped_datasets {
+public:
+  explicit mapped_datasets(std::string file_name)
+      : file_name_(std::move(file_name)) {}
+
+  // Returns the contents of the dataset `label` in `f`.  Contiguous,
+  // unfiltered datasets stored in the native representation of `T` are
+  // mapped without copying; any other dataset is read into a buffer.
+  template <typename T>
+  std::span<T> map_dataset(H5::Group& f, const std::string& label) {
+    H5::DataSet dataset = f.openDataSet(label.c_str());
+
+    H5::DataSpace space = dataset.getSpace();
+    hsize_t ndims = space.getSimpleExtentNdims();
+    assert(ndims == 1);
+    hsize_t size;
+    space.getSimpleExtentDims(&size, &ndims);
+
+    if (size == 0) {
+      return {};
+    }
+
+    if (T* data = try_map<T>(dataset, size)) {
+      return std::span<T>(data, size);
+    }
+
+    std::shared_ptr<T[]> buffer(new T[size]);
+    hdf5_tools::read_dataset(dataset, 0, size, buffer.get());
+    storage_.push_back(buffer);
+    return std::span<T>(buffer.get(), size);
+  }
+
+  // Number of datasets that were mapped rather than copied.
+  std::size_t num_mapped() const {
+    return num_mapped_;
+  }
+
+private:
+  template <typename T>
+  T* try_map(H5::DataSet& dataset, hsize_t size) {
+    if constexpr (std::endian::native != std::endian::little ||
+                  std::is_same_v<T, bool>) {
+      return nullptr;
+    } else {
+      if (!(dataset.getDataType() == hdf5_tools::get_hdf5_native_type<T>())) {
+        return nullptr;
+      }
+
+      auto property_list = dataset.getCreatePlist();
+      if (property_list.getLayout() != H5D_CONTIGUOUS ||
+          property_list.getNfilters() != 0) {
+        return nullptr;
+      }
+
+      haddr_t offset = H5Dget_offset(dataset.getId());
+      if (offset == HADDR_UNDEF || offset % alignof(T) != 0) {
+        return nullptr;
+      }
+
+      auto mapping =
+          std::make_shared<mapped_file>(file_name_, offset, size * sizeof(T));
+      storage_.push_back(mapping);
+      num_mapped_++;
+      return reinterpret_cast<T*>(mapping->data());
+    }
+  }
+
+  std::string file_name_;
+  std::vector<std::shared_ptr<void>> storage_;
+  std::size_t num_mapped_ = 0;
+};
+
+} // namespace __detail
+
+/// A matrix whose arrays point directly into a memory-mapped Binsparse file.
+/// The arrays remain valid for as long as any copy of the handle is alive.
+/// Writes to the arrays are private to the process and never reach the file.
+template <typename Matrix>
+class mapped_matrix {
+public:
+  mapped_matrix(Matrix matrix, __detail::mapped_datasets storage)
+      : matrix_(matrix),
+        storage_(std::make_shared<__detail::mapped_datasets>(
+            std::move(storage))) {}
+
+  Matrix& matrix() {
+    return matrix_;
+  }
+
+  const Matrix& matrix() const {
+    return matrix_;
+  }
+
+  /// Number of arrays mapped from the file.  Arrays that could not be mapped,
+  /// because they are compressed, chunked or stored in a non-native type, are
+  /// read into buffers owned by the handle instead.
+  std::size_t num_mapped() const {
+    return storage_->num_mapped();
+  }
+
+private:
+  Matrix matrix_;
+  std::shared_ptr<__detail::mapped_datasets> storage_;
+};
+
+/// Read the CSR matrix stored in `fname` without copying its arrays.  Files
+/// written with `write_options::uncompressed()` are mapped entirely, making
+/// the load time independent of the matrix size.
+template <typename T, typename I, typename P = I>
+mapped_matrix<csr_matrix<T, I, P>>
+read_csr_matrix_mapped(std::string fname) {
+  auto f = hdf5_tools::open_read_only(fname);
+  __detail::mapped_datasets storage(fname);
+
+  auto binsparse_metadata = __detail::read_binsparse_metadata(f);
+
+  assert(binsparse_metadata["format"] == "CSR");
+
+  I nrows = binsparse_metadata["shape"][0];
+  I ncols = binsparse_metadata["shape"][1];
+  P nnz = binsparse_metadata["nnz"];
+
+  auto values = storage.map_dataset<T>(f, "values");
+  auto colind = storage.map_dataset<I>(f, "indices_1");
+  auto row_ptr = storage.map_dataset<P>(f, "pointers_to_1");
+
+  auto structure = __detail::read_structure(binsparse_metadata);
+
+  csr_matrix<T, I, P> matrix{values.data(), colind.data(), row_ptr.data(),
+                             nrows,         ncols,         nnz,
+                             structure};
+
+  return mapped_matrix(matrix, std::move(storage));
+}
+
+/// Read the CSC matrix stored in `fname` without copying its arrays.
+template <typename T, typename I, typename P = I>
+mapped_matrix<csc_matrix<T, I, P>>
+read_csc_matrix_mapped(std::string fname) {
+  auto f = hdf5_tools::open_read_only(fname);
+  __detail::mapped_datasets storage(fname);
+
+  auto binsparse_metadata = __detail::read_binsparse_metadata(f);
+
+  assert(binsparse_metadata["format"] == "CSC");
+
+  I nrows = binsparse_metadata["shape"][0];
+  I ncols = binsparse_metadata["shape"][1];
+  P nnz = binsparse_metadata["nnz"];
+
+  auto values = storage.map_dataset<T>(f, "values");
+  auto rowind = storage.map_dataset<I>(f, "indices_1");
+  auto col_ptr = storage.map_dataset<P>(f, "pointers_to_1");
+
+  auto structure = __detail::read_structure(binsparse_metadata);
+
+  csc_matrix<T, I, P> matrix{values.data(), rowind.data(), col_ptr.data(),
+                             nrows,         ncols,         nnz,
+                             structure};
+
+  return mapped_matrix(matrix, std::move(storage));
+}
+
+/// Read the COO matrix stored in `fname` without copying its arrays.
+template <typename T, typename I>
+mapped_matrix<coo_matrix<T, I>> read_coo_matrix_mapped(std::string fname) {
+  auto f = hdf5_tools::open_read_only(fname);
+  __detail::mapped_datasets storage(fname);
+
+  auto binsparse_metadata = __detail::read_binsparse_metadata(f);
+
+  auto format = __detail::unalias_format(binsparse_metadata["format"]);
+
+  assert(format == "COOR" || format == "COOC");
+
+  I nrows = binsparse_metadata["shape"][0];
+  I ncols = binsparse_metadata["shape"][1];
+  I nnz = binsparse_metadata["nnz"];
+
+  auto values = storage.map_dataset<T>(f, "values");
+  auto rows = storage.map_dataset<I>(f, "indices_0");
+  auto cols = storage.map_dataset<I>(f, "indices_1");
+
+  auto structure = __detail::read_structure(binsparse_metadata);
+
+  coo_matrix<T, I> matrix{values.data(), rows.data(), cols.data(), nrows,
+                          ncols,         nnz,         structure};
+
+  return mapped_matrix(matrix, std::move(storage));
+}
+
+/// Read the dense matrix stored in `fname` without copying its values.
+template <typename T, typename I, typename Order>
+mapped_matrix<dense_matrix<T, I, Order>>
+read_dense_matrix_mapped(std::string fname) {
+  auto f = hdf5_tools::open_read_only(fname);
+  __detail::mapped_datasets storage(fname);
+
+  auto binsparse_metadata = __detail::read_binsparse_metadata(f);
+
+  auto format = __detail::unalias_format(binsparse_metadata["format"]);
+
+  assert(format ==
+         __detail::get_matrix_format_string(dense_matrix<T, I, Order>{}));
+
+  I nrows = binsparse_metadata["shape"][0];
+  I ncols = binsparse_metadata["shape"][1];
+
+  auto values = storage.map_dataset<T>(f, "values");
+
+  auto structure = __detail::read_structure(binsparse_metadata);
+
+  dense_matrix<T, I, Order> matrix{values.data(), nrows, ncols, structure};
+
+  return mapped_matrix(matrix, std::move(storage));
+}
+
+} // namespace binsparse
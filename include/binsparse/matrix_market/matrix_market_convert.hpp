@@ -0,0 +1,375 @@
+#pragma once
+
+#include <binsparse/binsparse.hpp>
+#include <binsparse/mapped_file.hpp>
+#include <binsparse/matrix_market/matrix_market_parse.hpp>
+#include <binsparse/radix_sort.hpp>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <span>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace binsparse {
+
+namespace __detail {
+
+template <typename T, typename I>
+struct mm_entry {
+  I row;
+  I col;
+  T value;
+};
+
+// Temporary files holding sorted runs, removed when the object is destroyed.
+class mm_run_files {
+public:
+  explicit mm_run_files(std::filesystem::path directory)
+      : directory_(std::move(directory)) {}
+
+  mm_run_files(const mm_run_files&) = delete;
+  mm_run_files& operator=(const mm_run_files&) = delete;
+
+  ~mm_run_files() {
+    for (auto&& path : paths_) {
+      std::error_code ec;
+      std::filesystem::remove(path, ec);
+    }
+  }
+
+  std::filesystem::path create() {
+    std::string name = "binsparse_run_";
+#if defined(__unix__) || defined(__APPLE__)
+    name += std::to_string(::getpid()) + "_";
+#endif
+    name += std::to_string(reinterpret_cast<std::uintptr_t>(this)) + "_" +
+            std::to_string(paths_.size()) + ".tmp";
+    paths_.push_back(directory_ / name);
+    return paths_.back();
+  }
+
+  const std::vector<std::filesystem::path>& paths() const {
+    return paths_;
+  }
+
+private:
+  std::filesystem::path directory_;
+  std::vector<std::filesystem::path> paths_;
+};
+
+// Sequential reader over one sorted run, holding a bounded buffer of entries.
+template <typename T, typename I>
+class mm_run_reader {
+public:
+  mm_run_reader(const std::filesystem::path& path, std::size_t buffer_size)
+      : f_(path, std::ios::binary),
+        buffer_(std::max<std::size_t>(buffer_size, 1)) {
+    refill();
+  }
+
+  bool empty() const {
+    return pos_ == size_;
+  }
+
+  const mm_entry<T, I>& front() const {
+    return buffer_[pos_];
+  }
+
+  void pop() {
+    if (++pos_ == size_) {
+      refill();
+    }
+  }
+
+private:
+  void refill() {
+    f_.read(reinterpret_cast<char*>(buffer_.data()),
+            buffer_.size() * sizeof(mm_entry<T, I>));
+    size_ = f_.gcount() / sizeof(mm_entry<T, I>);
+    pos_ = 0;
+  }
+
+  std::ifstream f_;
+  std::vector<mm_entry<T, I>> buffer_;
+  std::size_t pos_ = 0;
+  std::size_t size_ = 0;
+};
+
+} // namespace __detail
+
+/// Convert the coordinate Matrix Market file at `input_file` into a Binsparse
+/// matrix stored in `f`, using `format` "COO" or "CSR", without holding the
+/// whole matrix in memory.
+///
+/// Entries are parsed into runs of at most `memory_budget` bytes, each run is
+/// sorted and spilled to a temporary file in `temp_directory`, and the runs
+/// are then k-way merged straight into chunked HDF5 datasets.  If the matrix
+/// fits in a single run nothing is spilled.  CSR output additionally keeps
+/// the `m + 1` row pointers in memory.  The datasets are stored according to
+/// `options`.
+template <typename T, typename I>
+void convert_matrix_market(
+    std::string input_file, H5::Group& f, std::string format,
+    std::size_t memory_budget, nlohmann::json user_keys = {},
+    std::filesystem::path temp_directory =
+        std::filesystem::temp_directory_path(),
+    const hdf5_tools::write_options& options = {},
+    std::size_t num_threads = __detail::default_num_threads()) {
+  using entry_type = __detail::mm_entry<T, I>;
+
+  if (format != "COO" && format != "CSR") {
+    throw std::runtime_error("convert_matrix_market: unsupported format " +
+                             format);
+  }
+
+  __detail::mapped_file file(input_file);
+  file.advise_sequential();
+
+  auto header = __detail::mm_parse_header(file.view(), input_file);
+
+  if (header.format != "coordinate") {
+    throw std::runtime_error(input_file +
+                             " could not be parsed as a Matrix Market file.");
+  }
+
+  bool pattern = header.type == "pattern";
+  structure_t structure;
+  if (header.structure == "general") {
+    structure = general;
+  } else if (header.structure == "symmetric") {
+    structure = symmetric;
+  } else {
+    throw std::runtime_error(input_file + " has an unsupported matrix type");
+  }
+
+  I m = header.m;
+  I n = header.n;
+
+  // The run buffers, the radix sort's scratch space and the packed sort keys
+  // all count against the budget.
+  std::size_t bytes_per_entry =
+      2 * (2 * sizeof(I) + sizeof(T)) + 2 * sizeof(std::uint64_t);
+  std::size_t run_capacity =
+      std::max<std::size_t>(memory_budget / bytes_per_entry, 1);
+
+  std::vector<I> rowind;
+  std::vector<I> colind;
+  std::vector<T> values;
+  rowind.reserve(std::min<std::size_t>(run_capacity, header.nnz));
+  colind.reserve(std::min<std::size_t>(run_capacity, header.nnz));
+  values.reserve(std::min<std::size_t>(run_capacity, header.nnz));
+
+  __detail::mm_run_files runs(temp_directory);
+  std::size_t nnz = 0;
+
+  auto spill = [&] {
+    __detail::sort_coo(rowind, colind, values, m, n, num_threads);
+
+    std::ofstream out(runs.create(), std::ios::binary);
+    std::vector<entry_type> block;
+    block.reserve(std::min<std::size_t>(rowind.size(), 1 << 16));
+
+    for (std::size_t k = 0; k < rowind.size(); k++) {
+      block.push_back({rowind[k], colind[k], values[k]});
+      if (block.size() == block.capacity() || k + 1 == rowind.size()) {
+        out.write(reinterpret_cast<const char*>(block.data()),
+                  block.size() * sizeof(entry_type));
+        block.clear();
+      }
+    }
+
+    if (!out) {
+      throw std::runtime_error(
+          "convert_matrix_market: failed to write temporary run file.");
+    }
+
+    rowind.clear();
+    colind.clear();
+    values.clear();
+  };
+
+  auto push = [&](I i, I j, T v) {
+    if (++nnz > header.nnz) {
+      throw std::runtime_error("read_MatrixMarket: error reading Matrix Market "
+                               "file, file has more nonzeros than reported.");
+    }
+    rowind.push_back(i);
+    colind.push_back(j);
+    values.push_back(v);
+    if (rowind.size() == run_capacity) {
+      spill();
+    }
+  };
+
+  __detail::mm_parse_coordinates<T>(header.body, pattern, true, m, n, push);
+
+  bool in_memory = runs.paths().empty();
+
+  if (in_memory) {
+    __detail::sort_coo(rowind, colind, values, m, n, num_threads);
+  } else if (!rowind.empty()) {
+    spill();
+  }
+
+  if (!in_memory) {
+    rowind = {};
+    colind = {};
+    values = {};
+  }
+
+  // Output staging buffers, flushed into the datasets whenever they fill.
+  std::size_t staging_capacity = std::max<std::size_t>(
+      memory_budget / 2 / (2 * sizeof(I) + sizeof(T)), 1);
+
+  std::vector<I> row_stage;
+  std::vector<I> col_stage;
+  std::vector<T> value_stage;
+
+  // Every flush except the last writes a whole number of chunks, so chunks
+  // are always written whole and never have to be read back and recompressed.
+  auto dataset_options = options;
+  dataset_options.chunk_elements =
+      std::min<hsize_t>(staging_capacity, options.chunk_size<T>(nnz));
+  staging_capacity -= staging_capacity % dataset_options.chunk_elements;
+
+  auto values_dataset =
+      hdf5_tools::create_dataset<T>(f, "values", nnz, dataset_options);
+  auto colind_dataset =
+      hdf5_tools::create_dataset<I>(f, "indices_1", nnz, dataset_options);
+  H5::DataSet rowind_dataset;
+  std::vector<I> row_ptr;
+
+  if (format == "COO") {
+    rowind_dataset =
+        hdf5_tools::create_dataset<I>(f, "indices_0", nnz, dataset_options);
+  } else {
+    row_ptr.resize(m + 1, 0);
+  }
+
+  std::size_t written = 0;
+
+  auto write_block = [&](std::span<const I> rows, std::span<const I> cols,
+                         std::span<const T> vals) {
+    hdf5_tools::write_dataset(values_dataset, written, vals, num_threads);
+    hdf5_tools::write_dataset(colind_dataset, written, cols, num_threads);
+    if (format == "COO") {
+      hdf5_tools::write_dataset(rowind_dataset, written, rows, num_threads);
+    } else {
+      for (auto&& i : rows) {
+        row_ptr[i + 1]++;
+      }
+    }
+    written += vals.size();
+  };
+
+  auto flush = [&] {
+    write_block(row_stage, col_stage, value_stage);
+    row_stage.clear();
+    col_stage.clear();
+    value_stage.clear();
+  };
+
+  auto emit = [&](I i, I j, T v) {
+    row_stage.push_back(i);
+    col_stage.push_back(j);
+    value_stage.push_back(v);
+    if (value_stage.size() == staging_capacity) {
+      flush();
+    }
+  };
+
+  if (in_memory) {
+    std::span<const I> rows(rowind);
+    std::span<const I> cols(colind);
+    std::span<const T> vals(values);
+    for (std::size_t k = 0; k < nnz; k += staging_capacity) {
+      std::size_t count = std::min(staging_capacity, nnz - k);
+      write_block(rows.subspan(k, count), cols.subspan(k, count),
+                  vals.subspan(k, count));
+    }
+  } else {
+    std::size_t n_runs = runs.paths().size();
+    std::size_t reader_buffer =
+        memory_budget / 2 / n_runs / sizeof(entry_type);
+
+    std::vector<__detail::mm_run_reader<T, I>> readers;
+    readers.reserve(n_runs);
+    for (auto&& path : runs.paths()) {
+      readers.emplace_back(path, reader_buffer);
+    }
+
+    // Min-heap of (row, column, run).  Ties are broken by run so that
+    // duplicate entries keep their order in the file.
+    using heap_entry = std::tuple<I, I, std::size_t>;
+    std::priority_queue<heap_entry, std::vector<heap_entry>, std::greater<>>
+        heap;
+
+    for (std::size_t r = 0; r < n_runs; r++) {
+      if (!readers[r].empty()) {
+        heap.push({readers[r].front().row, readers[r].front().col, r});
+      }
+    }
+
+    while (!heap.empty()) {
+      auto r = std::get<2>(heap.top());
+      heap.pop();
+
+      auto&& e = readers[r].front();
+      emit(e.row, e.col, e.value);
+      readers[r].pop();
+
+      if (!readers[r].empty()) {
+        heap.push({readers[r].front().row, readers[r].front().col, r});
+      }
+    }
+  }
+
+  flush();
+
+  if (format == "CSR") {
+    for (std::size_t r = 0; r < std::size_t(m); r++) {
+      row_ptr[r + 1] += row_ptr[r];
+    }
+    hdf5_tools::write_dataset(f, "pointers_to_1", row_ptr, options);
+  }
+
+  values_dataset.close();
+  colind_dataset.close();
+  if (format == "COO") {
+    rowind_dataset.close();
+  }
+
+  using json = nlohmann::json;
+  json j;
+  j["binsparse"]["version"] = version;
+  j["binsparse"]["format"] = format;
+  j["binsparse"]["shape"] = {m, n};
+  j["binsparse"]["nnz"] = nnz;
+  if (format == "COO") {
+    j["binsparse"]["data_types"]["indices_0"] = type_info<I>::label();
+  } else {
+    j["binsparse"]["data_types"]["pointers_to_1"] = type_info<I>::label();
+  }
+  j["binsparse"]["data_types"]["indices_1"] = type_info<I>::label();
+  j["binsparse"]["data_types"]["values"] = type_info<T>::label();
+
+  if (structure != general) {
+    j["binsparse"]["structure"] =
+        __detail::get_structure_name(structure).value();
+  }
+
+  for (auto&& v : user_keys.items()) {
+    j[v.key()] = v.value();
+  }
+
+  hdf5_tools::set_attribute(f, "binsparse", j.dump(2));
+}
+
+} // namespace binsparse
@@ -0,0 +1,299 @@
+#pragma once
+
+#include <algorithm>
+#include <binsparse/parallel.hpp>
+#include <charconv>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+namespace binsparse {
+
+namespace __detail {
+
+// Minimum number of bytes of Matrix Market body handed to each parsing
+// thread.  Smaller files are parsed with fewer threads.
+inline constexpr std::size_t mm_min_bytes_per_thread = 1 << 20;
+
+inline const char* mm_skip_blanks(const char* first, const char* last) {
+  while (first != last && (*first == ' ' || *first == '\t')) {
+    ++first;
+  }
+  return first;
+}
+
+inline const char* mm_skip_line(const char* first, const char* last) {
+  auto newline =
+      static_cast<const char*>(std::memchr(first, '\n', last - first));
+  return newline == nullptr ? last : newline + 1;
+}
+
+// Parse a single number of type `T` starting at `first`, skipping leading
+// blanks.  Returns a pointer one past the parsed characters, or `nullptr` if
+// no number could be parsed.
+template <typename T>
+const char* mm_parse_number(const char* first, const char* last, T& value) {
+  first = mm_skip_blanks(first, last);
+
+  if (first != last && *first == '+') {
+    ++first;
+  }
+
+  if constexpr (std::is_same_v<T, bool>) {
+    int v = 0;
+    auto [ptr, ec] = std::from_chars(first, last, v);
+    value = (v != 0);
+    return ec == std::errc() ? ptr : nullptr;
+  } else if constexpr (std::is_arithmetic_v<T>) {
+    auto [ptr, ec] = std::from_chars(first, last, value);
+    return ec == std::errc() ? ptr : nullptr;
+  } else {
+    // Fall back on iostreams for types `std::from_chars` cannot handle.
+    auto end = mm_skip_line(first, last);
+    std::istringstream ss(std::string(first, end));
+    if (!(ss >> value)) {
+      return nullptr;
+    }
+    auto consumed = ss.tellg();
+    return consumed < 0 ? end : first + consumed;
+  }
+}
+
+// Header of a Matrix Market file.
+struct mm_header {
+  std::string format;    // coordinate / array
+  std::string type;      // real / integer / complex / pattern
+  std::string structure; // general / symmetric / skew-symmetric / Hermitian
+  std::string comment;
+  std::size_t m = 0, n = 0, nnz = 0;
+  std::string_view body; // everything following the size line
+};
+
+// Remove and return the next line of `contents`, without its line ending.
+inline std::string_view mm_next_line(std::string_view& contents) {
+  auto end = contents.find('\n');
+  auto line = contents.substr(0, end);
+  contents.remove_prefix(end == std::string_view::npos ? contents.size()
+                                                       : end + 1);
+  if (!line.empty() && line.back() == '\r') {
+    line.remove_suffix(1);
+  }
+  return line;
+}
+
+// Remove and return the next whitespace-delimited token of `line`.
+inline std::string_view mm_next_token(std::string_view& line) {
+  auto first = line.find_first_not_of(" \t");
+  if (first == std::string_view::npos) {
+    line = {};
+    return {};
+  }
+  line.remove_prefix(first);
+  auto last = std::min(line.find_first_of(" \t"), line.size());
+  auto token = line.substr(0, last);
+  line.remove_prefix(last);
+  return token;
+}
+
+// Parse the banner, comments and size line at the start of `contents`, which
+// holds the full contents of the Matrix Market file at `file_path`.
+inline mm_header mm_parse_header(std::string_view contents,
+                                 const std::string& file_path) {
+  auto error = [&] {
+    return std::runtime_error(file_path +
+                              " could not be parsed as a Matrix Market file.");
+  };
+
+  mm_header header;
+
+  auto banner = mm_next_line(contents);
+
+  if (mm_next_token(banner) != "%%MatrixMarket") {
+    throw error();
+  }
+
+  if (mm_next_token(banner) != "matrix") {
+    throw error();
+  }
+
+  header.format = mm_next_token(banner);
+  header.type = mm_next_token(banner);
+  header.structure = mm_next_token(banner);
+
+  std::string_view size_line;
+  bool outOfComments = false;
+  while (!outOfComments) {
+    if (contents.empty()) {
+      throw error();
+    }
+
+    size_line = mm_next_line(contents);
+
+    header.comment += size_line;
+    header.comment += "\n";
+
+    auto first = size_line.find_first_not_of(" \t");
+    if (first != std::string_view::npos && size_line[first] != '%') {
+      outOfComments = true;
+    }
+  }
+
+  const char* first = size_line.data();
+  const char* last = size_line.data() + size_line.size();
+
+  first = mm_parse_number(first, last, header.m);
+  if (first != nullptr) {
+    first = mm_parse_number(first, last, header.n);
+  }
+  if (first == nullptr) {
+    throw error();
+  }
+
+  if (header.format == "coordinate") {
+    first = mm_parse_number(first, last, header.nnz);
+    if (first == nullptr) {
+      throw error();
+    }
+  } else {
+    header.nnz = header.m * header.n;
+  }
+
+  header.body = contents;
+
+  return header;
+}
+
+// Split `body` into at most `num_threads` byte ranges, each beginning at the
+// start of a line.  Returns the `n + 1` boundaries of the `n` ranges.
+inline std::vector<std::size_t> mm_split_lines(std::string_view body,
+                                               std::size_t num_threads) {
+  num_threads = std::max<std::size_t>(
+      1, std::min(num_threads, body.size() / mm_min_bytes_per_thread));
+
+  std::vector<std::size_t> bounds;
+  bounds.push_back(0);
+
+  for (std::size_t t = 1; t < num_threads; t++) {
+    std::size_t pos = std::max(bounds.back(), body.size() * t / num_threads);
+    pos = body.find('\n', pos);
+    if (pos == std::string_view::npos) {
+      break;
+    }
+    bounds.push_back(pos + 1);
+  }
+
+  bounds.push_back(body.size());
+
+  return bounds;
+}
+
+// Parse the coordinate entries in `body` (the part of a Matrix Market file
+// following the size line), calling `emit(i, j, v)` for every entry.  Blank
+// lines and comment lines are skipped, and any trailing fields on a line (e.g.
+// the imaginary part of a complex entry) are ignored.
+template <typename T, typename I, typename Fn>
+void mm_parse_coordinates(std::string_view body, bool pattern,
+                          bool one_indexed, I m, I n, Fn&& emit) {
+  const char* first = body.data();
+  const char* last = body.data() + body.size();
+
+  while (first != last) {
+    first = mm_skip_blanks(first, last);
+
+    if (first == last) {
+      break;
+    }
+
+    if (*first == '\n' || *first == '\r' || *first == '%') {
+      first = mm_skip_line(first, last);
+      continue;
+    }
+
+    I i, j;
+    T v;
+
+    const char* ptr = mm_parse_number(first, last, i);
+    if (ptr != nullptr) {
+      ptr = mm_parse_number(ptr, last, j);
+    }
+    if (ptr != nullptr) {
+      if (!pattern) {
+        ptr = mm_parse_number(ptr, last, v);
+      } else {
+        v = T(1);
+      }
+    }
+
+    if (ptr == nullptr) {
+      auto end = mm_skip_line(first, last);
+      throw std::runtime_error(
+          "read_MatrixMarket: could not parse entry \"" +
+          std::string(first, end - (end != first && end[-1] == '\n')) + "\"");
+    }
+
+    if (one_indexed) {
+      i--;
+      j--;
+    }
+
+    if constexpr (std::is_signed_v<I>) {
+      if (i < 0 || j < 0) {
+        throw std::runtime_error(
+            "read_MatrixMarket: file has nonzero out of bounds.");
+      }
+    }
+
+    if (i >= m || j >= n) {
+      throw std::runtime_error(
+          "read_MatrixMarket: file has nonzero out of bounds.");
+    }
+
+    emit(i, j, v);
+
+    first = mm_skip_line(ptr, last);
+  }
+}
+
+// Parse the values in `body` (the part of an "array" Matrix Market file
+// following the size line), calling `emit(v)` for every value in file order.
+template <typename T, typename Fn>
+void mm_parse_values(std::string_view body, Fn&& emit) {
+  const char* first = body.data();
+  const char* last = body.data() + body.size();
+
+  while (first != last) {
+    first = mm_skip_blanks(first, last);
+
+    if (first == last) {
+      break;
+    }
+
+    if (*first == '\n' || *first == '\r' || *first == '%') {
+      first = mm_skip_line(first, last);
+      continue;
+    }
+
+    T v;
+    const char* ptr = mm_parse_number(first, last, v);
+
+    if (ptr == nullptr) {
+      auto end = mm_skip_line(first, last);
+      throw std::runtime_error(
+          "read_MatrixMarket: could not parse value \"" +
+          std::string(first, end - (end != first && end[-1] == '\n')) + "\"");
+    }
+
+    emit(v);
+
+    first = mm_skip_line(ptr, last);
+  }
+}
+
+} // namespace __detail
+
+} // namespace binsparse
@@ -1,8 +1,16 @@
 #pragma once
 
-#include <fstream>
-#include <iostream>
+#include <algorithm>
+#include <binsparse/mapped_file.hpp>
+#include <binsparse/matrix_market/matrix_market_parse.hpp>
+#include <binsparse/parallel.hpp>
+#include <binsparse/radix_sort.hpp>
+#include <cassert>
+#include <numeric>
 #include <ranges>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
 
 namespace binsparse {
 
@@ -73,6 +81,123 @@ public:
     }
   }
 
+  // Take ownership of COO arrays sorted in row-major order.  `colind` and
+  // `values` are moved into the matrix without copying.
+  void assign_arrays(std::vector<I>&& rowind, std::vector<I>&& colind,
+                     std::vector<T>&& values,
+                     std::size_t num_threads = default_num_threads()) {
+    std::size_t m = std::get<0>(shape());
+    std::size_t nnz = rowind.size();
+    values_ = std::move(values);
+    colind_ = std::move(colind);
+    rowptr_.resize(m + 1);
+
+    // Each row boundary is found where the row index changes, so every entry
+    // of `rowptr_` is written by exactly one thread.
+    std::size_t nt = std::max<std::size_t>(
+        1, std::min(num_threads, nnz / radix_min_per_thread));
+
+    parallel_for(nt, [&](std::size_t t) {
+      auto [first, last] = block_range(nnz, t, nt);
+      for (std::size_t i = first; i < last; i++) {
+        std::size_t begin = i == 0 ? 0 : std::size_t(rowind[i - 1]) + 1;
+        for (std::size_t r = begin; r <= std::size_t(rowind[i]); r++) {
+          rowptr_[r] = i;
+        }
+      }
+    });
+
+    std::size_t tail = nnz == 0 ? 0 : std::size_t(rowind[nnz - 1]) + 1;
+    std::fill(rowptr_.begin() + tail, rowptr_.end(), nnz);
+  }
+
+  // Build the matrix from COO arrays in any order, without a global sort.
+  // Entries are bucketed by row with a counting sort (per-thread row
+  // histograms, a prefix sum into `rowptr_` and a stable scatter), after which
+  // only the rows whose column indices are out of order are sorted.  Input
+  // that is already sorted in row-major order is moved in directly.
+  void assign_unsorted(std::vector<I>&& rowind, std::vector<I>&& colind,
+                       std::vector<T>&& values,
+                       std::size_t num_threads = default_num_threads()) {
+    if (is_row_major_sorted(rowind, colind, num_threads)) {
+      assign_arrays(std::move(rowind), std::move(colind), std::move(values),
+                    num_threads);
+      return;
+    }
+
+    // std::vector<bool> cannot be written concurrently.
+    if constexpr (std::is_same_v<T, bool>) {
+      num_threads = 1;
+    }
+
+    std::size_t m = std::get<0>(shape());
+    std::size_t nnz = rowind.size();
+
+    // Limit the number of histograms so their total size stays within nnz.
+    std::size_t nt = std::max<std::size_t>(
+        1, std::min({num_threads, nnz / radix_min_per_thread,
+                     nnz / std::max<std::size_t>(m, 1)}));
+
+    std::vector<I> counts(nt * m, 0);
+
+    parallel_for(nt, [&](std::size_t t) {
+      auto local = counts.begin() + t * m;
+      auto [first, last] = block_range(nnz, t, nt);
+      for (std::size_t i = first; i < last; i++) {
+        local[rowind[i]]++;
+      }
+    });
+
+    rowptr_.assign(m + 1, 0);
+
+    std::size_t row_threads = std::max<std::size_t>(
+        1, std::min(num_threads, m / radix_min_per_thread));
+
+    parallel_for(row_threads, [&](std::size_t rt) {
+      auto [first, last] = block_range(m, rt, row_threads);
+      for (std::size_t r = first; r < last; r++) {
+        for (std::size_t t = 0; t < nt; t++) {
+          rowptr_[r + 1] += counts[t * m + r];
+        }
+      }
+    });
+
+    parallel_inclusive_scan(rowptr_.data(), m + 1, num_threads);
+
+    // Turn the histograms into per-thread scatter offsets.
+    parallel_for(row_threads, [&](std::size_t rt) {
+      auto [first, last] = block_range(m, rt, row_threads);
+      for (std::size_t r = first; r < last; r++) {
+        I offset = rowptr_[r];
+        for (std::size_t t = 0; t < nt; t++) {
+          I count = counts[t * m + r];
+          counts[t * m + r] = offset;
+          offset += count;
+        }
+      }
+    });
+
+    colind_.resize(nnz);
+    values_.resize(nnz);
+
+    parallel_for(nt, [&](std::size_t t) {
+      auto local = counts.begin() + t * m;
+      auto [first, last] = block_range(nnz, t, nt);
+      for (std::size_t i = first; i < last; i++) {
+        auto pos = local[rowind[i]]++;
+        colind_[pos] = colind[i];
+        values_[pos] = values[i];
+      }
+    });
+
+    counts = {};
+    rowind = {};
+    colind = {};
+    values = {};
+
+    sort_rows(row_threads);
+  }
+
   auto shape() const {
     return shape_;
   }
@@ -86,6 +211,44 @@ public:
   }
 
 private:
+  // Sort the column indices (and values) of every row that is not already
+  // sorted.
+  void sort_rows(std::size_t num_threads) {
+    std::size_t m = std::get<0>(shape());
+
+    parallel_for(num_threads, [&](std::size_t t) {
+      std::vector<std::size_t> perm;
+      std::vector<I> colind_tmp;
+      std::vector<T> values_tmp;
+
+      auto [first, last] = block_range(m, t, num_threads);
+      for (std::size_t r = first; r < last; r++) {
+        auto row_begin = colind_.begin() + rowptr_[r];
+        auto row_end = colind_.begin() + rowptr_[r + 1];
+
+        if (std::is_sorted(row_begin, row_end)) {
+          continue;
+        }
+
+        std::size_t len = row_end - row_begin;
+        perm.resize(len);
+        std::iota(perm.begin(), perm.end(), std::size_t(0));
+        std::stable_sort(perm.begin(), perm.end(), [&](auto a, auto b) {
+          return row_begin[a] < row_begin[b];
+        });
+
+        colind_tmp.assign(row_begin, row_end);
+        values_tmp.assign(values_.begin() + rowptr_[r],
+                          values_.begin() + rowptr_[r + 1]);
+
+        for (std::size_t k = 0; k < len; k++) {
+          colind_[rowptr_[r] + k] = colind_tmp[perm[k]];
+          values_[rowptr_[r] + k] = values_tmp[perm[k]];
+        }
+      }
+    });
+  }
+
   std::tuple<I, I> shape_;
   std::vector<T> values_;
   std::vector<I> rowptr_;
@@ -137,6 +300,14 @@ public:
     }
   }
 
+  // Take ownership of COO arrays without copying.
+  void assign_arrays(std::vector<I>&& rowind, std::vector<I>&& colind,
+                     std::vector<T>&& values) {
+    rowind_ = std::move(rowind);
+    colind_ = std::move(colind);
+    values_ = std::move(values);
+  }
+
   void reserve(std::size_t size) {
     values_.reserve(size);
     rowind_.reserve(size);
@@ -165,131 +336,125 @@ private:
 
 /// Read in the Matrix Market file at location `file_path` and
 /// return a data structure with the matrix.
+///
+/// The body of the file is split into newline-aligned byte ranges which are
+/// parsed concurrently by up to `num_threads` threads.
 template <typename T, typename I, typename MatrixType>
-inline MatrixType mmread(std::string file_path, bool one_indexed = true) {
+inline MatrixType mmread(std::string file_path, bool one_indexed = true,
+                         std::size_t num_threads = default_num_threads()) {
   using index_type = I;
   using size_type = std::size_t;
 
-  std::ifstream f;
+  // The file is mapped into memory and parsed in place.
+  mapped_file f(file_path);
+  f.advise_sequential();
 
-  f.open(file_path.c_str());
-
-  if (!f.is_open()) {
-    // TODO better choice of exception.
-    throw std::runtime_error("mmread: cannot open " + file_path);
-  }
-
-  std::string buf;
+  auto header = mm_parse_header(f.view(), file_path);
 
   // Make sure the file is matrix market matrix, coordinate, and check whether
   // it is symmetric. If the matrix is symmetric.
   // Error out if skew-symmetric or Hermitian.
-  std::getline(f, buf);
-  std::istringstream ss(buf);
-  std::string item;
-  ss >> item;
-  if (item != "%%MatrixMarket") {
-    throw std::runtime_error(file_path +
-                             " could not be parsed as a Matrix Market file.");
-  }
-  ss >> item;
-  if (item != "matrix") {
+  if (header.format != "coordinate") {
     throw std::runtime_error(file_path +
                              " could not be parsed as a Matrix Market file.");
   }
-  ss >> item;
-  if (item != "coordinate") {
-    throw std::runtime_error(file_path +
-                             " could not be parsed as a Matrix Market file.");
-  }
-  bool pattern;
-  ss >> item;
-  if (item == "pattern") {
-    pattern = true;
-  } else {
-    pattern = false;
-  }
+  bool pattern = header.type == "pattern";
   // TODO: do something with real vs. integer vs. pattern?
-  ss >> item;
   structure_t structure;
-  if (item == "general") {
+  if (header.structure == "general") {
     structure = general;
-  } else if (item == "symmetric") {
+  } else if (header.structure == "symmetric") {
     structure = symmetric;
   } else {
     throw std::runtime_error(file_path + " has an unsupported matrix type");
   }
 
-  bool outOfComments = false;
-  while (!outOfComments) {
-    std::getline(f, buf);
-
-    if (buf[0] != '%') {
-      outOfComments = true;
-    }
-  }
-
-  I m, n, nnz;
-  // std::istringstream ss(buf);
-  ss.clear();
-  ss.str(buf);
-  ss >> m >> n >> nnz;
+  I m = header.m;
+  I n = header.n;
+  I nnz = header.nnz;
 
   MatrixType m_out({m, n}, structure);
 
-  using coo_type = std::vector<std::tuple<std::tuple<I, I>, T>>;
-  coo_type matrix;
-  matrix.reserve(nnz);
+  std::string_view body = header.body;
 
-  size_type c = 0;
-  while (std::getline(f, buf)) {
-    I i, j;
-    T v;
-    std::istringstream ss(buf);
-    if (!pattern) {
-      ss >> i >> j >> v;
-    } else {
-      ss >> i >> j;
-      v = T(1);
-    }
-    if (one_indexed) {
-      i--;
-      j--;
-    }
+  // Each thread parses its byte range into its own row, column and value
+  // arrays, which are then concatenated in file order.
+  struct coo_arrays {
+    std::vector<I> rowind;
+    std::vector<I> colind;
+    std::vector<T> values;
+  };
 
-    if (i >= m || j >= n) {
-      throw std::runtime_error(
-          "read_MatrixMarket: file has nonzero out of bounds.");
-    }
+  auto bounds = mm_split_lines(body, num_threads);
+  std::size_t n_chunks = bounds.size() - 1;
 
-    matrix.push_back({{i, j}, v});
+  std::vector<coo_arrays> chunks(n_chunks);
 
-    c++;
-    if (c > nnz) {
-      throw std::runtime_error("read_MatrixMarket: error reading Matrix Market "
-                               "file, file has more nonzeros than reported.");
-    }
+  parallel_for(n_chunks, [&](std::size_t t) {
+    std::string_view chunk(body.data() + bounds[t], bounds[t + 1] - bounds[t]);
+    auto&& [rowind, colind, values] = chunks[t];
+    rowind.reserve(nnz / n_chunks + 1);
+    colind.reserve(nnz / n_chunks + 1);
+    values.reserve(nnz / n_chunks + 1);
+    mm_parse_coordinates<T>(chunk, pattern, one_indexed, m, n,
+                            [&](I i, I j, T v) {
+                              rowind.push_back(i);
+                              colind.push_back(j);
+                              values.push_back(v);
+                            });
+  });
+
+  std::vector<size_type> offsets(n_chunks + 1, 0);
+  for (size_type t = 0; t < n_chunks; t++) {
+    offsets[t + 1] = offsets[t] + chunks[t].rowind.size();
   }
 
-  auto sort_fn = [](auto&& a, auto&& b) {
-    auto&& [a_idx, a_v] = a;
-    auto&& [b_idx, b_v] = b;
+  if (offsets.back() > size_type(nnz)) {
+    throw std::runtime_error("read_MatrixMarket: error reading Matrix Market "
+                             "file, file has more nonzeros than reported.");
+  }
 
-    auto&& [a_i, a_j] = a_idx;
-    auto&& [b_i, b_j] = b_idx;
+  coo_arrays matrix;
 
-    if (a_i != b_i) {
-      return a_i < b_i;
+  if (n_chunks == 1) {
+    matrix = std::move(chunks[0]);
+  } else {
+    matrix.rowind.resize(offsets.back());
+    matrix.colind.resize(offsets.back());
+    matrix.values.resize(offsets.back());
+
+    auto copy_chunk = [&](std::size_t t) {
+      std::ranges::copy(chunks[t].rowind, matrix.rowind.begin() + offsets[t]);
+      std::ranges::copy(chunks[t].colind, matrix.colind.begin() + offsets[t]);
+      std::ranges::copy(chunks[t].values, matrix.values.begin() + offsets[t]);
+      chunks[t] = coo_arrays{};
+    };
+
+    // std::vector<bool> cannot be written concurrently.
+    if constexpr (std::is_same_v<T, bool>) {
+      for (std::size_t t = 0; t < n_chunks; t++) {
+        copy_chunk(t);
+      }
     } else {
-      return a_j < b_j;
+      parallel_for(n_chunks, copy_chunk);
     }
-  };
-
-  std::sort(matrix.begin(), matrix.end(), sort_fn);
+  }
 
-  m_out.assign_tuples(matrix.begin(), matrix.end());
+  // Containers that can bucket unsorted entries themselves (e.g. CSR) skip
+  // the global sort.
+  if constexpr (requires(MatrixType& mat, std::vector<I> idx,
+                         std::vector<T> vals) {
+                  mat.assign_unsorted(std::move(idx), std::move(idx),
+                                      std::move(vals), std::size_t());
+                }) {
+    m_out.assign_unsorted(std::move(matrix.rowind), std::move(matrix.colind),
+                          std::move(matrix.values), num_threads);
+  } else {
+    sort_coo(matrix.rowind, matrix.colind, matrix.values, m, n, num_threads);
 
-  f.close();
+    m_out.assign_arrays(std::move(matrix.rowind), std::move(matrix.colind),
+                        std::move(matrix.values));
+  }
 
   return m_out;
 }
@@ -302,69 +467,30 @@ inline std::vector<T> mmread_array(std::string file_path,
   using size_type = std::size_t;
   using I = std::size_t;
 
-  std::ifstream f;
-
-  f.open(file_path.c_str());
-
-  if (!f.is_open()) {
-    // TODO better choice of exception.
-    throw std::runtime_error("mmread: cannot open " + file_path);
-  }
+  mapped_file f(file_path);
+  f.advise_sequential();
 
-  std::string buf;
+  auto header = mm_parse_header(f.view(), file_path);
 
-  // Make sure the file is matrix market matrix, coordinate, and check whether
-  // it is symmetric. If the matrix is symmetric.
-  // Error out if skew-symmetric or Hermitian.
-  std::getline(f, buf);
-  std::istringstream ss(buf);
-  std::string item;
-  ss >> item;
-  if (item != "%%MatrixMarket") {
-    throw std::runtime_error(file_path +
-                             " could not be parsed as a Matrix Market file.");
-  }
-  ss >> item;
-  if (item != "matrix") {
-    throw std::runtime_error(file_path +
-                             " could not be parsed as a Matrix Market file.");
-  }
-  ss >> item;
-  if (item != "array") {
+  if (header.format != "array") {
     throw std::runtime_error(file_path +
                              " could not be parsed as a Matrix Market file.");
   }
-  ss >> item;
-  assert(item != "pattern");
-
-  ss >> item;
-  assert(item == "general");
-
-  bool outOfComments = false;
-  while (!outOfComments) {
-    std::getline(f, buf);
-
-    if (buf[0] != '%') {
-      outOfComments = true;
-    }
-  }
+  assert(header.type != "pattern");
+  assert(header.structure == "general");
 
-  I m, n, nnz;
-  // std::istringstream ss(buf);
-  ss.clear();
-  ss.str(buf);
-  ss >> m >> n;
-  nnz = m * n;
+  I m = header.m;
+  I n = header.n;
+  I nnz = header.nnz;
 
   std::vector<T> m_out(m * n);
 
-  constexpr bool pattern = true;
-
   size_type c = 0;
-  while (std::getline(f, buf)) {
-    T v;
-    std::istringstream ss(buf);
-    ss >> v;
+  mm_parse_values<T>(header.body, [&](T v) {
+    if (c >= nnz) {
+      throw std::runtime_error("read_MatrixMarket: error reading Matrix Market "
+                               "file, file has more nonzeros than reported.");
+    }
 
     I i = c % m;
     I j = c / m;
@@ -372,13 +498,7 @@ inline std::vector<T> mmread_array(std::string file_path,
     m_out[i * n + j] = v;
 
     c++;
-    if (c > nnz) {
-      throw std::runtime_error("read_MatrixMarket: error reading Matrix Market "
-                               "file, file has more nonzeros than reported.");
-    }
-  }
-
-  f.close();
+  });
 
   return m_out;
 }
@@ -0,0 +1,322 @@
+#pragma once
+
+#include <binsparse/binsparse.hpp>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace binsparse {
+
+/// A batch of stored values read by `stream_nonzeros`.  Entry `k` is the value
+/// `values[k]` at row `rowind[k]` and column `colind[k]`.
+template <typename T, typename I>
+struct nonzero_batch {
+  std::vector<I> rowind;
+  std::vector<I> colind;
+  std::vector<T> values;
+
+  std::size_t size() const {
+    return values.size();
+  }
+};
+
+namespace __detail {
+
+// Reads the stored values of a COO, CSR or CSC matrix in consecutive batches.
+// For the compressed formats, the pointer array is read in windows as the
+// batches advance, so memory use is bounded by the batch size for any matrix.
+template <typename T, typename I>
+class nonzero_source {
+public:
+  nonzero_source(const std::string& fname, std::size_t batch_size,
+                 std::size_t num_threads)
+      : f_(hdf5_tools::open_read_only(fname)), num_threads_(num_threads) {
+    auto binsparse_metadata = read_binsparse_metadata(f_);
+
+    format_ = unalias_format(binsparse_metadata["format"]);
+    m_ = binsparse_metadata["shape"][0];
+    n_ = binsparse_metadata["shape"][1];
+    nnz_ = binsparse_metadata["nnz"];
+
+    if (format_ != "COOR" && format_ != "COOC" && format_ != "CSR" &&
+        format_ != "CSC") {
+      throw std::runtime_error("stream_nonzeros: unsupported format " +
+                               format_);
+    }
+
+    values_ = f_.openDataSet("values");
+    indices_1_ = f_.openDataSet("indices_1");
+    if (format_ == "CSR" || format_ == "CSC") {
+      pointers_ = f_.openDataSet("pointers_to_1");
+    } else {
+      indices_0_ = f_.openDataSet("indices_0");
+    }
+
+    // Batches covering whole chunks of every dataset read by offset never
+    // decompress a chunk twice.  The datasets' chunk lengths differ when
+    // their element sizes do, so batches are rounded to a common multiple.
+    // With byte-based chunking the lengths are powers of two, and this is
+    // the largest of them.
+    std::size_t chunk = chunk_length(values_);
+    for (auto* dataset : {&indices_0_, &indices_1_}) {
+      if (dataset->getId() != H5I_INVALID_HID) {
+        std::size_t length = chunk_length(*dataset);
+        std::size_t multiple = std::lcm(chunk, length);
+        chunk = multiple <= 64 * std::max(chunk, length)
+                    ? multiple
+                    : std::max(chunk, length);
+      }
+    }
+
+    batch_size_ = std::max<std::size_t>(batch_size, 1);
+    batch_size_ = (batch_size_ + chunk - 1) / chunk * chunk;
+
+    if (pointers_.getId() != H5I_INVALID_HID) {
+      pointer_chunk_ = chunk_length(pointers_);
+    }
+  }
+
+  // Read the next batch into `batch`, which is left empty once every stored
+  // value has been read.
+  void read(nonzero_batch<T, I>& batch) {
+    std::size_t count = std::min(batch_size_, nnz_ - offset_);
+
+    batch.rowind.resize(count);
+    batch.colind.resize(count);
+    batch.values.resize(count);
+
+    hdf5_tools::read_dataset(values_, offset_, count, batch.values.data(),
+                             num_threads_);
+
+    if (format_ == "CSR" || format_ == "CSC") {
+      auto&& major = format_ == "CSR" ? batch.rowind : batch.colind;
+      auto&& minor = format_ == "CSR" ? batch.colind : batch.rowind;
+
+      hdf5_tools::read_dataset(indices_1_, offset_, count, minor.data(),
+                               num_threads_);
+
+      for (std::size_t k = 0; k < count; k++) {
+        while (std::size_t(pointer(major_ + 1)) <= offset_ + k) {
+          major_++;
+        }
+        major[k] = I(major_);
+      }
+    } else {
+      hdf5_tools::read_dataset(indices_0_, offset_, count,
+                               batch.rowind.data(), num_threads_);
+      hdf5_tools::read_dataset(indices_1_, offset_, count,
+                               batch.colind.data(), num_threads_);
+    }
+
+    offset_ += count;
+  }
+
+  std::size_t m() const {
+    return m_;
+  }
+
+  std::size_t n() const {
+    return n_;
+  }
+
+  std::size_t nnz() const {
+    return nnz_;
+  }
+
+private:
+  // Number of elements in each chunk of `dataset`, or 1 if it is not
+  // chunked.
+  static std::size_t chunk_length(H5::DataSet& dataset) {
+    auto property_list = dataset.getCreatePlist();
+    if (property_list.getLayout() != H5D_CHUNKED) {
+      return 1;
+    }
+    hsize_t chunk;
+    property_list.getChunk(1, &chunk);
+    return chunk;
+  }
+
+  // Pointer `i`, read along with the following pointers when it is not in
+  // the current window.  Pointers are only ever requested in increasing
+  // order.  Windows start and end on chunk boundaries, so that no chunk of
+  // the pointers is decompressed twice.
+  I pointer(std::size_t i) {
+    if (i >= window_first_ + window_.size()) {
+      std::size_t num_pointers = (format_ == "CSR" ? m_ : n_) + 1;
+      std::size_t window =
+          (batch_size_ + pointer_chunk_) / pointer_chunk_ * pointer_chunk_;
+      window_first_ = i / pointer_chunk_ * pointer_chunk_;
+      window_.resize(std::min(window, num_pointers - window_first_));
+      hdf5_tools::read_dataset(pointers_, window_first_, window_.size(),
+                               window_.data(), num_threads_);
+    }
+    return window_[i - window_first_];
+  }
+
+  H5::H5File f_;
+  H5::DataSet values_;
+  H5::DataSet indices_0_;
+  H5::DataSet indices_1_;
+  H5::DataSet pointers_;
+
+  std::string format_;
+  std::size_t m_;
+  std::size_t n_;
+  std::size_t nnz_;
+  std::size_t batch_size_;
+  std::size_t pointer_chunk_ = 1;
+  std::size_t num_threads_;
+
+  std::size_t offset_ = 0;
+  std::size_t major_ = 0;
+  std::vector<I> window_;
+  std::size_t window_first_ = 0;
+};
+
+// Reading ahead on a background thread is only safe by default when HDF5
+// serializes its own calls.
+#ifdef H5_HAVE_THREADSAFE
+inline constexpr bool default_prefetch = true;
+#else
+inline constexpr bool default_prefetch = false;
+#endif
+
+} // namespace __detail
+
+/// An input range over the stored values of a matrix in a Binsparse file, in
+/// batches of `nonzero_batch<T, I>`, returned by `stream_nonzeros`.  Each
+/// batch stays valid until the iterator is incremented.
+template <typename T, typename I>
+class nonzero_stream {
+  struct state {
+    state(const std::string& fname, std::size_t batch_size, bool prefetch,
+          std::size_t num_threads)
+        : source(fname, batch_size, num_threads), prefetch(prefetch) {}
+
+    // Advance `current` to the next batch, and start reading the one after
+    // it in the background.
+    void advance() {
+      if (prefetch) {
+        if (pending.valid()) {
+          pending.get();
+        } else {
+          source.read(next);
+        }
+        std::swap(current, next);
+        pending =
+            std::async(std::launch::async, [this] { source.read(next); });
+      } else {
+        source.read(current);
+      }
+    }
+
+    __detail::nonzero_source<T, I> source;
+    bool prefetch;
+    nonzero_batch<T, I> current;
+    nonzero_batch<T, I> next;
+    std::future<void> pending;
+  };
+
+public:
+  class iterator {
+  public:
+    using value_type = nonzero_batch<T, I>;
+    using difference_type = std::ptrdiff_t;
+
+    iterator() = default;
+
+    const value_type& operator*() const {
+      return state_->current;
+    }
+
+    const value_type* operator->() const {
+      return &state_->current;
+    }
+
+    iterator& operator++() {
+      state_->advance();
+      return *this;
+    }
+
+    void operator++(int) {
+      ++*this;
+    }
+
+    bool operator==(std::default_sentinel_t) const {
+      return state_->current.size() == 0;
+    }
+
+  private:
+    friend nonzero_stream;
+
+    explicit iterator(state* state) : state_(state) {}
+
+    state* state_ = nullptr;
+  };
+
+  nonzero_stream(const std::string& fname, std::size_t batch_size,
+                 bool prefetch, std::size_t num_threads)
+      : state_(std::make_unique<state>(fname, batch_size, prefetch,
+                                       num_threads)) {}
+
+  /// Read the first batch.  Like any input range, the stream can be iterated
+  /// only once.
+  iterator begin() {
+    state_->advance();
+    return iterator(state_.get());
+  }
+
+  std::default_sentinel_t end() const {
+    return {};
+  }
+
+  /// Number of rows of the matrix.
+  std::size_t m() const {
+    return state_->source.m();
+  }
+
+  /// Number of columns of the matrix.
+  std::size_t n() const {
+    return state_->source.n();
+  }
+
+  /// Number of stored values in the matrix.
+  std::size_t nnz() const {
+    return state_->source.nnz();
+  }
+
+private:
+  std::unique_ptr<state> state_;
+};
+
+/// Stream the stored values of the COO, CSR or CSC matrix in `fname` in
+/// batches of about `batch_size` entries, rounded up to whole chunks, reading
+/// and decompressing only one batch at a time.  Matrices of any size can thus
+/// be processed in bounded memory:
+///
+///   for (auto&& batch : binsparse::stream_nonzeros<float, int>(fname)) {
+///     for (std::size_t k = 0; k < batch.size(); k++) {
+///       degree[batch.rowind[k]]++;
+///     }
+///   }
+///
+/// CSR and CSC values are produced in storage order, with their compressed
+/// indices expanded.  With `prefetch`, the next batch is read on a background
+/// thread while the current one is processed; unless HDF5 was built
+/// thread-safe, the loop body must then not call HDF5 itself.  `prefetch`
+/// is on by default only when HDF5 was built thread-safe.
+template <typename T, typename I>
+nonzero_stream<T, I>
+stream_nonzeros(const std::string& fname,
+                std::size_t batch_size = std::size_t(1) << 20,
+                bool prefetch = __detail::default_prefetch,
+                std::size_t num_threads = __detail::default_num_threads()) {
+  return nonzero_stream<T, I>(fname, batch_size, prefetch, num_threads);
+}
+
+} // namespace binsparse
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace binsparse {
+
+namespace __detail {
+
+// Number of threads used by the parallel kernels when the caller does not
+// request a specific count.  Can be overridden with the environment variable
+// `BINSPARSE_NUM_THREADS`.
+inline std::size_t default_num_threads() {
+  if (const char* env = std::getenv("BINSPARSE_NUM_THREADS")) {
+    try {
+      auto n = std::stoull(env);
+      if (n > 0) {
+        return n;
+      }
+    } catch (...) {
+    }
+  }
+  return std::max<std::size_t>(1, std::thread::hardware_concurrency());
+}
+
+// Return the half-open range [first, last) of `n` items assigned to thread
+// `tid` out of `num_threads` when the items are split into equal blocks.
+inline std::pair<std::size_t, std::size_t>
+block_range(std::size_t n, std::size_t tid, std::size_t num_threads) {
+  std::size_t block = n / num_threads;
+  std::size_t rem = n % num_threads;
+  std::size_t first = tid * block + std::min(tid, rem);
+  std::size_t last = first + block + (tid < rem ? 1 : 0);
+  return {first, last};
+}
+
+// Invoke `fn(tid)` for every `tid` in [0, num_threads), each on its own
+// thread.  Thread 0 runs on the calling thread.  If any invocation throws, the
+// first exception (by thread index) is rethrown after all threads have joined.
+template <typename Fn>
+void parallel_for(std::size_t num_threads, Fn&& fn) {
+  num_threads = std::max<std::size_t>(1, num_threads);
+
+  if (num_threads == 1) {
+    fn(std::size_t(0));
+    return;
+  }
+
+  std::vector<std::exception_ptr> errors(num_threads);
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+
+  auto run = [&](std::size_t tid) {
+    try {
+      fn(tid);
+    } catch (...) {
+      errors[tid] = std::current_exception();
+    }
+  };
+
+  for (std::size_t tid = 1; tid < num_threads; tid++) {
+    threads.emplace_back(run, tid);
+  }
+
+  run(0);
+
+  for (auto&& thread : threads) {
+    thread.join();
+  }
+
+  for (auto&& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+// Replace the first `n` elements of `data` with their inclusive prefix sum,
+// computed with up to `num_threads` threads.
+template <typename T>
+void parallel_inclusive_scan(T* data, std::size_t n, std::size_t num_threads) {
+  constexpr std::size_t min_per_thread = 1 << 16;
+
+  num_threads =
+      std::max<std::size_t>(1, std::min(num_threads, n / min_per_thread));
+
+  std::vector<T> block_sums(num_threads, 0);
+
+  parallel_for(num_threads, [&](std::size_t t) {
+    auto [first, last] = block_range(n, t, num_threads);
+    for (std::size_t i = first + 1; i < last; i++) {
+      data[i] += data[i - 1];
+    }
+    if (first < last) {
+      block_sums[t] = data[last - 1];
+    }
+  });
+
+  for (std::size_t t = 1; t < num_threads; t++) {
+    block_sums[t] += block_sums[t - 1];
+  }
+
+  parallel_for(num_threads, [&](std::size_t t) {
+    if (t > 0) {
+      auto [first, last] = block_range(n, t, num_threads);
+      for (std::size_t i = first; i < last; i++) {
+        data[i] += block_sums[t - 1];
+      }
+    }
+  });
+}
+
+} // namespace __detail
+
+} // namespace binsparse
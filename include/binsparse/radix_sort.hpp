@@ -0,0 +1,196 @@
+#pragma once
+
+#include <algorithm>
+#include <binsparse/parallel.hpp>
+#include <bit>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace binsparse {
+
+namespace __detail {
+
+inline constexpr std::size_t radix_bits = 8;
+inline constexpr std::size_t radix_buckets = std::size_t(1) << radix_bits;
+
+// Minimum number of elements handed to each thread by the sorting kernels.
+inline constexpr std::size_t radix_min_per_thread = 1 << 16;
+
+// Stable LSD radix sort of `keys`, considering only the low `key_bits` bits,
+// applying the same permutation to every array in `payload`.  Each pass
+// computes per-thread digit histograms over contiguous blocks and then
+// scatters each block to its precomputed offsets, so the result is identical
+// for any thread count.  Passes in which every key has the same digit are
+// skipped.
+template <typename Key, typename... Ts>
+void lsd_radix_sort(std::vector<Key>& keys, std::size_t key_bits,
+                    std::size_t num_threads, std::vector<Ts>&... payload) {
+  using U = std::make_unsigned_t<Key>;
+
+  std::size_t n = keys.size();
+
+  if (n <= 1) {
+    return;
+  }
+
+  // std::vector<bool> cannot be written concurrently.
+  if constexpr ((std::is_same_v<Ts, bool> || ...)) {
+    num_threads = 1;
+  }
+
+  num_threads = std::max<std::size_t>(
+      1, std::min(num_threads, n / radix_min_per_thread));
+
+  std::vector<Key> keys_tmp(n);
+  std::tuple<std::vector<Ts>...> payload_tmp{std::vector<Ts>(n)...};
+  auto payload_refs = std::tie(payload...);
+
+  auto move_payload = [&]<std::size_t... Is>(std::index_sequence<Is...>,
+                                             std::size_t from, std::size_t to) {
+    ((std::get<Is>(payload_tmp)[to] = std::get<Is>(payload_refs)[from]), ...);
+  };
+
+  std::vector<std::size_t> counts(num_threads * radix_buckets);
+
+  for (std::size_t shift = 0; shift < key_bits; shift += radix_bits) {
+    auto digit = [&](Key key) {
+      return (U(key) >> shift) & (radix_buckets - 1);
+    };
+
+    parallel_for(num_threads, [&](std::size_t t) {
+      auto local = counts.begin() + t * radix_buckets;
+      std::fill(local, local + radix_buckets, 0);
+      auto [first, last] = block_range(n, t, num_threads);
+      for (std::size_t i = first; i < last; i++) {
+        local[digit(keys[i])]++;
+      }
+    });
+
+    // Convert the histograms into scatter offsets, ordered by digit and then
+    // by thread so that the sort remains stable.
+    bool trivial = false;
+    std::size_t offset = 0;
+    for (std::size_t d = 0; d < radix_buckets; d++) {
+      std::size_t bucket_start = offset;
+      for (std::size_t t = 0; t < num_threads; t++) {
+        auto count = counts[t * radix_buckets + d];
+        counts[t * radix_buckets + d] = offset;
+        offset += count;
+      }
+      if (offset - bucket_start == n) {
+        trivial = true;
+      }
+    }
+
+    if (trivial) {
+      continue;
+    }
+
+    parallel_for(num_threads, [&](std::size_t t) {
+      auto local = counts.begin() + t * radix_buckets;
+      auto [first, last] = block_range(n, t, num_threads);
+      for (std::size_t i = first; i < last; i++) {
+        auto pos = local[digit(keys[i])]++;
+        keys_tmp[pos] = keys[i];
+        move_payload(std::index_sequence_for<Ts...>{}, i, pos);
+      }
+    });
+
+    keys.swap(keys_tmp);
+    [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+      (std::get<Is>(payload_refs).swap(std::get<Is>(payload_tmp)), ...);
+    }(std::index_sequence_for<Ts...>{});
+  }
+}
+
+// Returns true if the entries given by `rowind` and `colind` are sorted in
+// row-major order.
+template <typename I>
+bool is_row_major_sorted(const std::vector<I>& rowind,
+                         const std::vector<I>& colind,
+                         std::size_t num_threads) {
+  std::size_t n = rowind.size();
+
+  num_threads = std::max<std::size_t>(
+      1, std::min(num_threads, n / radix_min_per_thread));
+
+  std::vector<char> sorted(num_threads, true);
+
+  parallel_for(num_threads, [&](std::size_t t) {
+    auto [first, last] = block_range(n, t, num_threads);
+    for (std::size_t i = std::max<std::size_t>(first, 1); i < last; i++) {
+      if (rowind[i - 1] > rowind[i] ||
+          (rowind[i - 1] == rowind[i] && colind[i - 1] > colind[i])) {
+        sorted[t] = false;
+        return;
+      }
+    }
+  });
+
+  return std::ranges::all_of(sorted, [](char s) { return bool(s); });
+}
+
+// Sort the COO entries stored in `rowind`, `colind` and `values` into
+// row-major order, in place.  When the row and column indices together fit in
+// 64 bits they are packed into a single key and sorted in one radix sort;
+// otherwise the entries are radix sorted by column and then stably by row.
+// The sort is stable, so duplicate entries keep their original order.
+template <typename T, typename I>
+void sort_coo(std::vector<I>& rowind, std::vector<I>& colind,
+              std::vector<T>& values, std::size_t m, std::size_t n,
+              std::size_t num_threads = default_num_threads()) {
+  if (is_row_major_sorted(rowind, colind, num_threads)) {
+    return;
+  }
+
+  std::size_t nnz = rowind.size();
+
+  std::size_t row_bits = std::bit_width(std::max<std::size_t>(m, 1) - 1);
+  std::size_t col_bits = std::bit_width(std::max<std::size_t>(n, 1) - 1);
+
+  auto sort_packed = [&]<typename Key>(Key) {
+    constexpr std::size_t width = 8 * sizeof(Key);
+
+    std::size_t nt = std::max<std::size_t>(
+        1, std::min(num_threads, nnz / radix_min_per_thread));
+
+    // Shifting by the full key width is undefined, and only happens when every
+    // row index is zero.
+    std::size_t row_shift = std::min(col_bits, width - 1);
+    Key col_mask = col_bits == 0 ? Key(0) : Key(Key(-1) >> (width - col_bits));
+
+    std::vector<Key> keys(nnz);
+    parallel_for(nt, [&](std::size_t t) {
+      auto [first, last] = block_range(nnz, t, nt);
+      for (std::size_t i = first; i < last; i++) {
+        keys[i] = (Key(rowind[i]) << row_shift) | Key(colind[i]);
+      }
+    });
+
+    lsd_radix_sort(keys, row_bits + col_bits, num_threads, values);
+
+    parallel_for(nt, [&](std::size_t t) {
+      auto [first, last] = block_range(nnz, t, nt);
+      for (std::size_t i = first; i < last; i++) {
+        rowind[i] = col_bits == width ? I(0) : I(keys[i] >> row_shift);
+        colind[i] = I(keys[i] & col_mask);
+      }
+    });
+  };
+
+  if (row_bits + col_bits <= 32) {
+    sort_packed(std::uint32_t());
+  } else if (row_bits + col_bits <= 64) {
+    sort_packed(std::uint64_t());
+  } else {
+    lsd_radix_sort(colind, col_bits, num_threads, rowind, values);
+    lsd_radix_sort(rowind, row_bits, num_threads, colind, values);
+  }
+}
+
+} // namespace __detail
+
+} // namespace binsparse
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <binsparse/any_matrix.hpp>
+#include <binsparse/binsparse.hpp>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace binsparse {
+
+/// A session for reading from one Binsparse container.  The file is opened
+/// once, the metadata is parsed once, and dataset handles are kept open, so
+/// repeated reads from the same container, or from the matrices stored in its
+/// groups, skip the open and parse work that the `read_*_matrix(fname)`
+/// functions repeat on every call.  Copies of a reader share its state.
+class reader {
+public:
+  /// Open the container stored in `fname` for reading.
+  explicit reader(const std::string& fname)
+      : reader(hdf5_tools::open_read_only(fname).openGroup("/")) {}
+
+  /// Read from the already open group `group`.
+  explicit reader(H5::Group group)
+      : state_(std::make_shared<state>(std::move(group))) {}
+
+  /// A session for the matrix stored in the group `name` of this container,
+  /// such as the auxiliary matrices written by `convert_ssmc.sh`.
+  reader group(const std::string& name) const {
+    auto&& groups = state_->groups;
+    auto iter = groups.find(name);
+    if (iter == groups.end()) {
+      auto group = state_->group.openGroup(name.c_str());
+      iter = groups.emplace(name, std::make_shared<state>(group)).first;
+    }
+    return reader(iter->second);
+  }
+
+  /// The complete metadata of the container, including user-provided keys.
+  const nlohmann::json& metadata() const {
+    if (!state_->metadata.has_value()) {
+      state_->metadata = nlohmann::json::parse(
+          hdf5_tools::get_attribute(state_->group, "binsparse"));
+    }
+    return state_->metadata.value();
+  }
+
+  /// The format of the stored matrix, with aliases resolved.
+  std::string format() const {
+    return __detail::unalias_format(binsparse_metadata()["format"]);
+  }
+
+  template <typename T, typename Allocator = std::allocator<T>>
+  auto read_dense_vector(Allocator&& alloc = Allocator{}) {
+    return __detail::read_dense_vector_impl<T>(*this, binsparse_metadata(),
+                                               alloc);
+  }
+
+  template <typename T, typename I, typename Order,
+            typename Allocator = std::allocator<T>>
+  auto read_dense_matrix(Allocator&& alloc = Allocator{}) {
+    return __detail::read_dense_matrix_impl<T, I, Order>(
+        *this, binsparse_metadata(), alloc);
+  }
+
+  template <typename T, typename I, typename P = I,
+            typename Allocator = std::allocator<T>>
+  csr_matrix<T, I, P> read_csr_matrix(Allocator&& alloc = Allocator{}) {
+    return __detail::read_csr_matrix_impl<T, I, P>(
+        *this, binsparse_metadata(), alloc);
+  }
+
+  template <typename T, typename I, typename P = I,
+            typename Allocator = std::allocator<T>>
+  csc_matrix<T, I, P> read_csc_matrix(Allocator&& alloc = Allocator{}) {
+    return __detail::read_csc_matrix_impl<T, I, P>(
+        *this, binsparse_metadata(), alloc);
+  }
+
+  template <typename T, typename I, typename P = I,
+            typename Allocator = std::allocator<T>>
+  dcsr_matrix<T, I, P> read_dcsr_matrix(Allocator&& alloc = Allocator{}) {
+    return __detail::read_dcsr_matrix_impl<T, I, P>(
+        *this, binsparse_metadata(), alloc);
+  }
+
+  template <typename T, typename I, typename P = I,
+            typename Allocator = std::allocator<T>>
+  dcsc_matrix<T, I, P> read_dcsc_matrix(Allocator&& alloc = Allocator{}) {
+    return __detail::read_dcsc_matrix_impl<T, I, P>(
+        *this, binsparse_metadata(), alloc);
+  }
+
+  template <typename T, typename I, typename Allocator = std::allocator<T>>
+  coo_matrix<T, I> read_coo_matrix(Allocator&& alloc = Allocator{}) {
+    return __detail::read_coo_matrix_impl<T, I>(*this, binsparse_metadata(),
+                                                alloc);
+  }
+
+  template <typename T, typename A>
+  std::span<T> read_dense_vector_into(std::vector<T, A>& values) {
+    return __detail::read_dense_vector_into_impl(*this, binsparse_metadata(),
+                                                 values);
+  }
+
+  template <typename T, typename I, typename Order, typename A>
+  dense_matrix<T, I, Order> read_dense_matrix_into(std::vector<T, A>& values) {
+    return __detail::read_dense_matrix_into_impl<T, I, Order>(
+        *this, binsparse_metadata(), values);
+  }
+
+  template <typename T, typename I, typename P, typename VA, typename IA,
+            typename PA>
+  csr_matrix<T, I, P> read_csr_matrix_into(std::vector<T, VA>& values,
+                                           std::vector<I, IA>& colind,
+                                           std::vector<P, PA>& row_ptr) {
+    return __detail::read_csr_matrix_into_impl(*this, binsparse_metadata(),
+                                               values, colind, row_ptr);
+  }
+
+  template <typename T, typename I, typename P, typename VA, typename IA,
+            typename PA>
+  csc_matrix<T, I, P> read_csc_matrix_into(std::vector<T, VA>& values,
+                                           std::vector<I, IA>& rowind,
+                                           std::vector<P, PA>& col_ptr) {
+    return __detail::read_csc_matrix_into_impl(*this, binsparse_metadata(),
+                                               values, rowind, col_ptr);
+  }
+
+  template <typename T, typename I, typename VA, typename IA>
+  coo_matrix<T, I> read_coo_matrix_into(std::vector<T, VA>& values,
+                                        std::vector<I, IA>& rowind,
+                                        std::vector<I, IA>& colind) {
+    return __detail::read_coo_matrix_into_impl(*this, binsparse_metadata(),
+                                               values, rowind, colind);
+  }
+
+  template <typename T, typename I, typename P = I,
+            typename Allocator = std::allocator<T>>
+  csr_matrix<T, I, P> read_csr_rows(std::size_t row_begin, std::size_t row_end,
+                                    Allocator&& alloc = Allocator{}) {
+    return __detail::read_csr_rows_impl<T, I, P>(*this, binsparse_metadata(),
+                                                 row_begin, row_end, alloc);
+  }
+
+  template <typename T, typename I, typename P = I,
+            typename Allocator = std::allocator<T>>
+  csc_matrix<T, I, P> read_csc_cols(std::size_t col_begin, std::size_t col_end,
+                                    Allocator&& alloc = Allocator{}) {
+    return __detail::read_csc_cols_impl<T, I, P>(*this, binsparse_metadata(),
+                                                 col_begin, col_end, alloc);
+  }
+
+  template <typename T, typename I, typename Allocator = std::allocator<T>>
+  coo_matrix<T, I> read_coo_rows(std::size_t row_begin, std::size_t row_end,
+                                 Allocator&& alloc = Allocator{}) {
+    return __detail::read_coo_rows_impl<T, I>(*this, metadata(), row_begin,
+                                              row_end, alloc);
+  }
+
+  /// Read the stored matrix, whatever its format and types.
+  any_matrix read_matrix() {
+    return __detail::read_matrix_impl(*this, binsparse_metadata());
+  }
+
+  /// Read only the values of the stored matrix into the existing matrix `m`.
+  template <typename Matrix>
+  void read_values_into(const Matrix& m, std::size_t num_threads =
+                                             __detail::default_num_threads()) {
+    __detail::read_values_into_impl(*this, binsparse_metadata(), m,
+                                    num_threads);
+  }
+
+  std::vector<std::uint64_t> partition_rows(std::size_t num_partitions) {
+    return __detail::partition_rows_impl(*this, metadata(), num_partitions);
+  }
+
+  template <typename T, typename I, typename P = I,
+            typename Allocator = std::allocator<T>>
+  csr_partition<T, I, P> read_partition(std::size_t p,
+                                        std::size_t num_partitions,
+                                        Allocator&& alloc = Allocator{}) {
+    if (p >= num_partitions) {
+      throw std::out_of_range("read_partition: partition out of range.");
+    }
+    auto boundaries = partition_rows(num_partitions);
+    auto matrix =
+        read_csr_rows<T, I, P>(boundaries[p], boundaries[p + 1], alloc);
+    return {matrix, boundaries[p], boundaries[p + 1]};
+  }
+
+  /// The dataset `label` of this container.  Handles are opened once and
+  /// cached for the lifetime of the session.
+  H5::DataSet openDataSet(const char* label) const {
+    auto&& datasets = state_->datasets;
+    auto iter = datasets.find(label);
+    if (iter == datasets.end()) {
+      iter = datasets.emplace(label, state_->group.openDataSet(label)).first;
+    }
+    return iter->second;
+  }
+
+private:
+  struct state {
+    explicit state(H5::Group group) : group(std::move(group)) {}
+
+    H5::Group group;
+    std::optional<nlohmann::json> metadata;
+    std::map<std::string, H5::DataSet> datasets;
+    std::map<std::string, std::shared_ptr<state>> groups;
+  };
+
+  explicit reader(std::shared_ptr<state> state) : state_(std::move(state)) {}
+
+  const nlohmann::json& binsparse_metadata() const {
+    return metadata()["binsparse"];
+  }
+
+  std::shared_ptr<state> state_;
+};
+
+} // namespace binsparse
@@ -45,8 +45,10 @@ struct type_info<uint64_t> {
   }
 };
 
-template <>
-struct type_info<std::size_t> {
+template <typename T>
+  requires(std::is_same_v<T, std::size_t> &&
+           !std::is_same_v<std::size_t, std::uint64_t>)
+struct type_info<T> {
   static constexpr auto label() noexcept {
     return "uint64";
   }
@@ -115,83 +117,62 @@ void invoke_if_able(Fn&& fn, Args&&... args) {}
 template <typename Fn, typename... Args>
 void invoke_visit_fn_impl_(std::vector<std::string> type_labels, Fn&& fn,
                            Args&&... args) {
-  if constexpr (sizeof...(Args) <= 3) {
-    // The first label we consume is the value label
-    if (type_labels.size() == 3) {
-      auto type_label = type_labels.front();
-      if (type_label == "uint8") {
-        invoke_if_able(std::forward<Fn>(fn), std::uint8_t(),
-                       std::forward<Args>(args)...);
-      } else if (type_label == "uint16") {
-        invoke_if_able(std::forward<Fn>(fn), std::uint16_t(),
-                       std::forward<Args>(args)...);
-      } else if (type_label == "uint32") {
-        invoke_if_able(std::forward<Fn>(fn), std::uint32_t(),
-                       std::forward<Args>(args)...);
-      } else if (type_label == "uint64") {
-        invoke_if_able(std::forward<Fn>(fn), std::uint64_t(),
-                       std::forward<Args>(args)...);
-      } else if (type_label == "int8") {
-        invoke_if_able(std::forward<Fn>(fn), std::int8_t(),
-                       std::forward<Args>(args)...);
-      } else if (type_label == "int16") {
-        invoke_if_able(std::forward<Fn>(fn), std::int16_t(),
-                       std::forward<Args>(args)...);
-      } else if (type_label == "int32") {
-        invoke_if_able(std::forward<Fn>(fn), std::int32_t(),
-                       std::forward<Args>(args)...);
-      } else if (type_label == "int64") {
-        invoke_if_able(std::forward<Fn>(fn), std::int64_t(),
-                       std::forward<Args>(args)...);
-      } else if (type_label == "float32") {
-        invoke_if_able(std::forward<Fn>(fn), float(),
-                       std::forward<Args>(args)...);
-      } else if (type_label == "float64") {
-        invoke_if_able(std::forward<Fn>(fn), double(),
-                       std::forward<Args>(args)...);
-      } else if (type_label == "bint8") {
-        invoke_if_able(std::forward<Fn>(fn), bool(),
-                       std::forward<Args>(args)...);
-      } else {
-        assert(false);
-      }
+  if (type_labels.empty()) {
+    invoke_if_able(std::forward<Fn>(fn), std::forward<Args>(args)...);
+  } else if constexpr (sizeof...(Args) < 3) {
+    // Labels are consumed from the back, so `fn` receives its types in the
+    // order of `type_labels`.  The last label is the value type and may be
+    // any type; the others are index or pointer types, which must be
+    // integral.
+    auto type_label = type_labels.back();
+    type_labels.pop_back();
+    if (type_label == "uint8") {
+      invoke_visit_fn_impl_(type_labels, std::forward<Fn>(fn), std::uint8_t(),
+                            std::forward<Args>(args)...);
+    } else if (type_label == "uint16") {
+      invoke_visit_fn_impl_(type_labels, std::forward<Fn>(fn), std::uint16_t(),
+                            std::forward<Args>(args)...);
+    } else if (type_label == "uint32") {
+      invoke_visit_fn_impl_(type_labels, std::forward<Fn>(fn), std::uint32_t(),
+                            std::forward<Args>(args)...);
+    } else if (type_label == "uint64") {
+      invoke_visit_fn_impl_(type_labels, std::forward<Fn>(fn), std::uint64_t(),
+                            std::forward<Args>(args)...);
+    } else if (type_label == "int8") {
+      invoke_visit_fn_impl_(type_labels, std::forward<Fn>(fn), std::int8_t(),
+                            std::forward<Args>(args)...);
+    } else if (type_label == "int16") {
+      invoke_visit_fn_impl_(type_labels, std::forward<Fn>(fn), std::int16_t(),
+                            std::forward<Args>(args)...);
+    } else if (type_label == "int32") {
+      invoke_visit_fn_impl_(type_labels, std::forward<Fn>(fn), std::int32_t(),
+                            std::forward<Args>(args)...);
+    } else if (type_label == "int64") {
+      invoke_visit_fn_impl_(type_labels, std::forward<Fn>(fn), std::int64_t(),
+                            std::forward<Args>(args)...);
     } else {
-      // The next two types are index types, which must be integrals.
-      auto type_label = type_labels.back();
-      type_labels.pop_back();
-      if (type_label == "uint8") {
-        invoke_visit_fn_impl_(type_labels, std::forward<Fn>(fn), std::uint8_t(),
-                              std::forward<Args>(args)...);
-      } else if (type_label == "uint16") {
-        invoke_visit_fn_impl_(type_labels, std::forward<Fn>(fn),
-                              std::uint16_t(), std::forward<Args>(args)...);
-      } else if (type_label == "uint32") {
-        invoke_visit_fn_impl_(type_labels, std::forward<Fn>(fn),
-                              std::uint32_t(), std::forward<Args>(args)...);
-      } else if (type_label == "uint64") {
-        invoke_visit_fn_impl_(type_labels, std::forward<Fn>(fn),
-                              std::uint64_t(), std::forward<Args>(args)...);
-      } else if (type_label == "int8") {
-        invoke_visit_fn_impl_(type_labels, std::forward<Fn>(fn), std::int8_t(),
-                              std::forward<Args>(args)...);
-      } else if (type_label == "int16") {
-        invoke_visit_fn_impl_(type_labels, std::forward<Fn>(fn), std::int16_t(),
-                              std::forward<Args>(args)...);
-      } else if (type_label == "int32") {
-        invoke_visit_fn_impl_(type_labels, std::forward<Fn>(fn), std::int32_t(),
-                              std::forward<Args>(args)...);
-      } else if (type_label == "int64") {
-        invoke_visit_fn_impl_(type_labels, std::forward<Fn>(fn), std::int64_t(),
-                              std::forward<Args>(args)...);
-      } else {
-        assert(false);
+      if constexpr (sizeof...(Args) == 0) {
+        if (type_label == "float32") {
+          invoke_visit_fn_impl_(type_labels, std::forward<Fn>(fn), float());
+          return;
+        } else if (type_label == "float64") {
+          invoke_visit_fn_impl_(type_labels, std::forward<Fn>(fn), double());
+          return;
+        } else if (type_label == "bint8") {
+          invoke_visit_fn_impl_(type_labels, std::forward<Fn>(fn), bool());
+          return;
+        }
       }
+      assert(false);
     }
   }
 }
 
 } // namespace __detail
 
+/// Invoke `fn` with a default-constructed value of each type named in
+/// `type_labels`, such as `{"uint64", "uint32", "float32"}` for the pointer,
+/// index and value types of a CSR matrix.  At most three labels are supported.
 template <typename Fn>
 inline void visit_label(const std::vector<std::string>& type_labels, Fn&& fn) {
   __detail::invoke_visit_fn_impl_(type_labels, fn);
@@ -3,6 +3,9 @@
 #include <fmt/core.h>
 
 #include <binsparse/binsparse.hpp>
+#include <binsparse/coo_appender.hpp>
+#include <binsparse/radix_sort.hpp>
+#include <binsparse/reader.hpp>
 
 inline std::vector file_paths({"1138_bus/1138_bus.mtx",
                                "chesapeake/chesapeake.mtx",
@@ -47,3 +50,210 @@ TEST(BinsparseReadWrite, COOFormat) {
     delete matrix_.colind;
   }
 }
+
+TEST(BinsparseReadWrite, ReaderSession) {
+  using T = float;
+  using I = std::size_t;
+
+  std::string binsparse_file = "out.bsp.hdf5";
+
+  std::vector<binsparse::__detail::coo_matrix_owning<T, I>> originals;
+
+  // Store the first matrix at the root and every matrix in its own group.
+  {
+    H5::H5File f(binsparse_file.c_str(), H5F_ACC_TRUNC);
+    for (std::size_t k = 0; k < file_paths.size(); k++) {
+      originals.push_back(binsparse::__detail::mmread<
+                          T, I, binsparse::__detail::coo_matrix_owning<T, I>>(
+          file_paths[k]));
+      auto&& x = originals.back();
+      auto&& [num_rows, num_columns] = x.shape();
+      binsparse::coo_matrix<T, I> matrix{x.values().data(), x.rowind().data(),
+                                         x.colind().data(), num_rows,
+                                         num_columns,       I(x.size())};
+      if (k == 0) {
+        binsparse::write_coo_matrix(f, matrix, {{"comment", "root"}});
+      }
+      H5::Group g = f.createGroup(std::to_string(k).c_str());
+      binsparse::write_coo_matrix(g, matrix);
+    }
+  }
+
+  auto expect_equal = [](auto&& x, auto&& matrix_) {
+    EXPECT_EQ(I(x.size()), matrix_.nnz);
+    for (I i = 0; i < matrix_.nnz; i++) {
+      EXPECT_EQ(x.values()[i], matrix_.values[i]);
+      EXPECT_EQ(x.rowind()[i], matrix_.rowind[i]);
+      EXPECT_EQ(x.colind()[i], matrix_.colind[i]);
+    }
+    delete matrix_.values;
+    delete matrix_.rowind;
+    delete matrix_.colind;
+  };
+
+  binsparse::reader r(binsparse_file);
+  EXPECT_EQ(r.format(), "COOR");
+  EXPECT_EQ(r.metadata()["comment"], "root");
+
+  // Repeated reads reuse the open file, metadata and datasets.
+  for (std::size_t pass = 0; pass < 2; pass++) {
+    expect_equal(originals[0], r.read_coo_matrix<T, I>());
+    for (std::size_t k = 0; k < file_paths.size(); k++) {
+      expect_equal(originals[k],
+                   r.group(std::to_string(k)).read_coo_matrix<T, I>());
+    }
+  }
+
+  // The group-handle overloads read the same matrices.
+  H5::H5File f(binsparse_file.c_str(), H5F_ACC_RDONLY);
+  for (std::size_t k = 0; k < file_paths.size(); k++) {
+    H5::Group g = f.openGroup(std::to_string(k).c_str());
+    expect_equal(originals[k], binsparse::read_coo_matrix<T, I>(g));
+  }
+}
+
+TEST(BinsparseReadWrite, COORowRanges) {
+  using T = float;
+  using I = std::size_t;
+
+  std::string binsparse_file = "out.bsp.hdf5";
+
+  for (auto&& file_path : file_paths) {
+    auto x = binsparse::__detail::mmread<
+        T, I, binsparse::__detail::coo_matrix_owning<T, I>>(file_path);
+    auto&& [num_rows, num_columns] = x.shape();
+
+    std::vector<I> rowind(x.rowind().begin(), x.rowind().end());
+    std::vector<I> colind(x.colind().begin(), x.colind().end());
+    std::vector<T> values(x.values().begin(), x.values().end());
+    binsparse::__detail::sort_coo(rowind, colind, values, num_rows,
+                                  num_columns);
+
+    binsparse::coo_matrix<T, I> matrix{values.data(), rowind.data(),
+                                       colind.data(), num_rows,
+                                       num_columns,   I(values.size())};
+
+    std::vector<std::pair<I, I>> ranges = {
+        {0, num_rows}, {0, 1}, {num_rows / 3, num_rows / 2},
+        {num_rows - 1, num_rows}, {num_rows / 2, num_rows / 2}};
+
+    // Small chunks, so that searches without an index span many chunks.
+    binsparse::write_options options;
+    options.chunk_elements = 100;
+
+    // Read the same ranges with and without a row index.
+    for (bool indexed : {false, true}) {
+      {
+        H5::H5File f(binsparse_file.c_str(), H5F_ACC_TRUNC);
+        binsparse::write_coo_matrix(f, matrix, {}, options);
+        if (indexed) {
+          binsparse::write_coo_row_index(f, matrix, 7);
+        }
+      }
+
+      binsparse::reader r(binsparse_file);
+      EXPECT_EQ(r.metadata().contains("row_index"), indexed);
+
+      for (auto&& [row_begin, row_end] : ranges) {
+        auto first =
+            std::lower_bound(rowind.begin(), rowind.end(), row_begin) -
+            rowind.begin();
+        auto last = std::lower_bound(rowind.begin(), rowind.end(), row_end) -
+                    rowind.begin();
+
+        auto rows =
+            binsparse::read_coo_rows<T, I>(binsparse_file, row_begin, row_end);
+        EXPECT_EQ(rows.m, row_end - row_begin);
+        EXPECT_EQ(rows.n, num_columns);
+        EXPECT_EQ(rows.nnz, I(last - first));
+        for (I k = 0; k < rows.nnz; k++) {
+          EXPECT_EQ(rows.rowind[k] + row_begin, rowind[first + k]);
+          EXPECT_EQ(rows.colind[k], colind[first + k]);
+          EXPECT_EQ(rows.values[k], values[first + k]);
+        }
+
+        auto session_rows = r.read_coo_rows<T, I>(row_begin, row_end);
+        EXPECT_EQ(session_rows.nnz, rows.nnz);
+
+        std::allocator<T> t_alloc;
+        std::allocator<I> i_alloc;
+        for (auto&& m : {rows, session_rows}) {
+          t_alloc.deallocate(m.values, m.nnz);
+          i_alloc.deallocate(m.rowind, m.nnz);
+          i_alloc.deallocate(m.colind, m.nnz);
+        }
+      }
+
+      auto read_past_end = [&] {
+        return r.read_coo_rows<T, I>(num_rows, num_rows + 1);
+      };
+      EXPECT_THROW(read_past_end(), std::out_of_range);
+    }
+
+    // The index requires entries sorted by row.
+    if (num_rows > 1 && rowind.front() != rowind.back()) {
+      std::swap(rowind.front(), rowind.back());
+      H5::H5File f(binsparse_file.c_str(), H5F_ACC_TRUNC);
+      binsparse::write_coo_matrix(f, matrix);
+      EXPECT_THROW(binsparse::write_coo_row_index(f, matrix),
+                   std::invalid_argument);
+    }
+  }
+}
+
+TEST(BinsparseReadWrite, COOAppender) {
+  using T = float;
+  using I = std::size_t;
+
+  std::string binsparse_file = "out.bsp.hdf5";
+
+  binsparse::write_options options;
+  options.chunk_elements = 100;
+
+  for (auto&& file_path : file_paths) {
+    auto x = binsparse::__detail::mmread<
+        T, I, binsparse::__detail::coo_matrix_owning<T, I>>(file_path);
+    auto&& [num_rows, num_columns] = x.shape();
+
+    std::span<const T> values(x.values());
+    std::span<const I> rowind(x.rowind());
+    std::span<const I> colind(x.colind());
+
+    // Batches of varying size, smaller and larger than a chunk.
+    {
+      binsparse::coo_appender<T, I> appender(
+          binsparse_file, num_rows, num_columns, {{"source", file_path}},
+          options);
+      std::size_t batch = 1;
+      for (std::size_t k = 0; k < values.size(); k += batch, batch *= 3) {
+        std::size_t count = std::min(batch, values.size() - k);
+        appender.append(rowind.subspan(k, count), colind.subspan(k, count),
+                        values.subspan(k, count));
+      }
+      EXPECT_EQ(appender.size(), values.size());
+
+      std::vector<I> bad_rows = {num_rows};
+      std::vector<I> cols = {0};
+      std::vector<T> vals = {1};
+      EXPECT_THROW(appender.append(bad_rows, cols, vals), std::out_of_range);
+      EXPECT_THROW(appender.append(cols, cols, {}), std::invalid_argument);
+    }
+
+    auto metadata = binsparse::inspect(binsparse_file);
+    EXPECT_EQ(metadata["source"], file_path);
+
+    auto matrix_ = binsparse::read_coo_matrix<T, I>(binsparse_file);
+    EXPECT_EQ(matrix_.m, num_rows);
+    EXPECT_EQ(matrix_.n, num_columns);
+    EXPECT_EQ(matrix_.nnz, I(values.size()));
+    for (I i = 0; i < matrix_.nnz; i++) {
+      EXPECT_EQ(values[i], matrix_.values[i]);
+      EXPECT_EQ(rowind[i], matrix_.rowind[i]);
+      EXPECT_EQ(colind[i], matrix_.colind[i]);
+    }
+
+    delete matrix_.values;
+    delete matrix_.rowind;
+    delete matrix_.colind;
+  }
+}
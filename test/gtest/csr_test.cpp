@@ -3,6 +3,9 @@
 #include <fmt/core.h>
 
 #include <binsparse/binsparse.hpp>
+#include <binsparse/mapped_read.hpp>
+#include <binsparse/nonzero_stream.hpp>
+#include <binsparse/reader.hpp>
 
 inline std::vector file_paths({"1138_bus/1138_bus.mtx",
                                "chesapeake/chesapeake.mtx",
@@ -47,3 +50,802 @@ TEST(BinsparseReadWrite, CSRFormat) {
     delete matrix_.colind;
   }
 }
+
+TEST(BinsparseReadWrite, CSRWriteOptions) {
+  using T = float;
+  using I = std::size_t;
+
+  std::string binsparse_file = "out.bsp.hdf5";
+
+  auto x = binsparse::__detail::mmread<
+      T, I, binsparse::__detail::csr_matrix_owning<T, I>>(file_paths[0]);
+
+  auto&& [num_rows, num_columns] = x.shape();
+  binsparse::csr_matrix<T, I> matrix{x.values().data(), x.colind().data(),
+                                     x.rowptr().data(), num_rows,
+                                     num_columns,       I(x.size())};
+
+  binsparse::write_options small_chunks;
+  small_chunks.chunk_elements = 100;
+  small_chunks.deflate_level = 0;
+
+  binsparse::write_options large_chunks;
+  large_chunks.chunk_bytes = 1 << 24;
+  large_chunks.deflate_level = 9;
+  large_chunks.shuffle = false;
+
+  std::vector<std::pair<binsparse::write_options, H5D_layout_t>> cases = {
+      {binsparse::write_options{}, H5D_CHUNKED},
+      {binsparse::write_options::uncompressed(), H5D_CONTIGUOUS},
+      {small_chunks, H5D_CHUNKED},
+      {large_chunks, H5D_CHUNKED}};
+
+  for (auto&& [options, layout] : cases) {
+    binsparse::write_csr_matrix(binsparse_file, matrix, {}, options);
+
+    {
+      H5::H5File f(binsparse_file.c_str(), H5F_ACC_RDONLY);
+      auto dataset = f.openDataSet("values");
+      auto property_list = dataset.getCreatePlist();
+      EXPECT_EQ(property_list.getLayout(), layout);
+      if (layout == H5D_CHUNKED) {
+        hsize_t chunk;
+        property_list.getChunk(1, &chunk);
+        EXPECT_EQ(chunk, options.chunk_size<T>(matrix.nnz));
+      }
+    }
+
+    auto matrix_ = binsparse::read_csr_matrix<T, I>(binsparse_file);
+
+    EXPECT_EQ(matrix.nnz, matrix_.nnz);
+
+    for (I i = 0; i < matrix.nnz; i++) {
+      EXPECT_EQ(matrix.values[i], matrix_.values[i]);
+      EXPECT_EQ(matrix.colind[i], matrix_.colind[i]);
+    }
+
+    for (I i = 0; i < matrix.m + 1; i++) {
+      EXPECT_EQ(matrix.row_ptr[i], matrix_.row_ptr[i]);
+    }
+
+    delete matrix_.values;
+    delete matrix_.row_ptr;
+    delete matrix_.colind;
+  }
+}
+
+TEST(BinsparseReadWrite, CSRMapped) {
+  using T = double;
+  using I = std::uint64_t;
+
+  std::string binsparse_file = "out.bsp.hdf5";
+
+  for (auto&& file_path : file_paths) {
+    auto x = binsparse::__detail::mmread<
+        T, I, binsparse::__detail::csr_matrix_owning<T, I>>(file_path);
+
+    auto&& [num_rows, num_columns] = x.shape();
+    binsparse::csr_matrix<T, I> matrix{x.values().data(), x.colind().data(),
+                                       x.rowptr().data(), num_rows,
+                                       num_columns,       I(x.size())};
+
+    for (bool compressed : {false, true}) {
+      auto options = compressed ? binsparse::write_options{}
+                                : binsparse::write_options::uncompressed();
+      binsparse::write_csr_matrix(binsparse_file, matrix, {}, options);
+
+      auto mapped = binsparse::read_csr_matrix_mapped<T, I>(binsparse_file);
+      auto&& matrix_ = mapped.matrix();
+
+      EXPECT_EQ(mapped.num_mapped(), compressed ? 0 : 3);
+
+      EXPECT_EQ(matrix.nnz, matrix_.nnz);
+      EXPECT_EQ(matrix.m, matrix_.m);
+      EXPECT_EQ(matrix.n, matrix_.n);
+
+      for (I i = 0; i < matrix.nnz; i++) {
+        EXPECT_EQ(matrix.values[i], matrix_.values[i]);
+        EXPECT_EQ(matrix.colind[i], matrix_.colind[i]);
+      }
+
+      for (I i = 0; i < matrix.m + 1; i++) {
+        EXPECT_EQ(matrix.row_ptr[i], matrix_.row_ptr[i]);
+      }
+    }
+  }
+}
+
+TEST(BinsparseReadWrite, CSRRowRanges) {
+  using T = float;
+  using I = std::size_t;
+
+  std::string binsparse_file = "out.bsp.hdf5";
+
+  for (auto&& file_path : file_paths) {
+    auto x = binsparse::__detail::mmread<
+        T, I, binsparse::__detail::csr_matrix_owning<T, I>>(file_path);
+
+    auto&& [num_rows, num_columns] = x.shape();
+    binsparse::csr_matrix<T, I> matrix{x.values().data(), x.colind().data(),
+                                       x.rowptr().data(), num_rows,
+                                       num_columns,       I(x.size())};
+
+    // Small chunks, so that ranges start and end inside chunks.
+    binsparse::write_options options;
+    options.chunk_elements = 1000;
+    binsparse::write_csr_matrix(binsparse_file, matrix, {}, options);
+
+    // The same arrays describe the transpose in CSC format.
+    std::string csc_file = "out.csc.bsp.hdf5";
+    binsparse::csc_matrix<T, I> transpose{matrix.values, matrix.colind,
+                                          matrix.row_ptr, matrix.n,
+                                          matrix.m,       matrix.nnz};
+    binsparse::write_csc_matrix(csc_file, transpose, {}, options);
+
+    std::size_t num_parts = 7;
+    for (std::size_t p = 0; p <= num_parts; p++) {
+      std::size_t first = std::min(num_rows, p * num_rows / num_parts);
+      std::size_t last = std::min(num_rows, (p + 2) * num_rows / num_parts);
+
+      auto rows = binsparse::read_csr_rows<T, I>(binsparse_file, first, last);
+      auto cols = binsparse::read_csc_cols<T, I>(csc_file, first, last);
+
+      EXPECT_EQ(rows.m, last - first);
+      EXPECT_EQ(rows.n, num_columns);
+      EXPECT_EQ(rows.nnz, matrix.row_ptr[last] - matrix.row_ptr[first]);
+      EXPECT_EQ(cols.m, num_columns);
+      EXPECT_EQ(cols.n, last - first);
+      EXPECT_EQ(cols.nnz, rows.nnz);
+
+      for (I i = 0; i <= rows.m; i++) {
+        EXPECT_EQ(rows.row_ptr[i],
+                  matrix.row_ptr[first + i] - matrix.row_ptr[first]);
+        EXPECT_EQ(cols.col_ptr[i], rows.row_ptr[i]);
+      }
+
+      for (I k = 0; k < rows.nnz; k++) {
+        EXPECT_EQ(rows.values[k], matrix.values[matrix.row_ptr[first] + k]);
+        EXPECT_EQ(rows.colind[k], matrix.colind[matrix.row_ptr[first] + k]);
+        EXPECT_EQ(cols.values[k], rows.values[k]);
+        EXPECT_EQ(cols.rowind[k], rows.colind[k]);
+      }
+
+      delete rows.values;
+      delete rows.colind;
+      delete rows.row_ptr;
+      delete cols.values;
+      delete cols.rowind;
+      delete cols.col_ptr;
+    }
+
+    auto read_past_end = [&] {
+      binsparse::read_csr_rows<T, I>(binsparse_file, 0, num_rows + 1);
+    };
+    EXPECT_THROW(read_past_end(), std::out_of_range);
+  }
+}
+
+TEST(BinsparseReadWrite, CSRPartitions) {
+  using T = float;
+  using I = std::size_t;
+
+  std::string binsparse_file = "out.bsp.hdf5";
+
+  for (auto&& file_path : file_paths) {
+    auto x = binsparse::__detail::mmread<
+        T, I, binsparse::__detail::csr_matrix_owning<T, I>>(file_path);
+
+    auto&& [num_rows, num_columns] = x.shape();
+    binsparse::csr_matrix<T, I> matrix{x.values().data(), x.colind().data(),
+                                       x.rowptr().data(), num_rows,
+                                       num_columns,       I(x.size())};
+
+    I max_row_nnz = 0;
+    for (I i = 0; i < matrix.m; i++) {
+      max_row_nnz =
+          std::max(max_row_nnz, matrix.row_ptr[i + 1] - matrix.row_ptr[i]);
+    }
+
+    for (bool precomputed : {false, true}) {
+      {
+        H5::H5File f(binsparse_file.c_str(), H5F_ACC_TRUNC);
+        binsparse::write_csr_matrix(f, matrix);
+        if (precomputed) {
+          binsparse::write_row_partitions(f, matrix, {4, 5});
+        }
+      }
+
+      if (precomputed) {
+        auto metadata = binsparse::inspect(binsparse_file);
+        EXPECT_EQ(metadata["row_partitions"], nlohmann::json({4, 5}));
+      }
+
+      std::size_t num_partitions = 5;
+      auto boundaries =
+          binsparse::partition_rows(binsparse_file, num_partitions);
+
+      ASSERT_EQ(boundaries.size(), num_partitions + 1);
+      EXPECT_EQ(boundaries.front(), 0);
+      EXPECT_EQ(boundaries.back(), matrix.m);
+
+      I offset = 0;
+      for (std::size_t p = 0; p < num_partitions; p++) {
+        auto [part, row_begin, row_end] = binsparse::read_partition<T, I>(
+            binsparse_file, p, num_partitions);
+
+        EXPECT_EQ(row_begin, boundaries[p]);
+        EXPECT_EQ(row_end, boundaries[p + 1]);
+        EXPECT_LE(part.nnz, matrix.nnz / num_partitions + max_row_nnz);
+
+        for (I k = 0; k < part.nnz; k++) {
+          EXPECT_EQ(part.values[k], matrix.values[offset + k]);
+          EXPECT_EQ(part.colind[k], matrix.colind[offset + k]);
+        }
+        offset += part.nnz;
+
+        delete part.values;
+        delete part.colind;
+        delete part.row_ptr;
+      }
+
+      EXPECT_EQ(offset, matrix.nnz);
+    }
+  }
+}
+
+TEST(BinsparseReadWrite, StreamNonzeros) {
+  using T = float;
+  using I = std::size_t;
+
+  std::string binsparse_file = "out.bsp.hdf5";
+
+  binsparse::write_options options;
+  options.chunk_elements = 64;
+
+  for (auto&& file_path : file_paths) {
+    auto x = binsparse::__detail::mmread<
+        T, I, binsparse::__detail::csr_matrix_owning<T, I>>(file_path);
+    auto&& [num_rows, num_columns] = x.shape();
+
+    binsparse::csr_matrix<T, I> matrix{x.values().data(), x.colind().data(),
+                                       x.rowptr().data(), num_rows,
+                                       num_columns,       I(x.size())};
+
+    std::vector<I> rowind(matrix.nnz);
+    for (I i = 0; i < matrix.m; i++) {
+      for (I k = matrix.row_ptr[i]; k < matrix.row_ptr[i + 1]; k++) {
+        rowind[k] = i;
+      }
+    }
+
+    binsparse::coo_matrix<T, I> coo{matrix.values, rowind.data(),
+                                    matrix.colind, num_rows,
+                                    num_columns,   matrix.nnz};
+
+    for (auto&& format : {"CSR", "COO"}) {
+      if (format == std::string("CSR")) {
+        binsparse::write_csr_matrix(binsparse_file, matrix, {}, options);
+      } else {
+        binsparse::write_coo_matrix(binsparse_file, coo, {}, options);
+      }
+
+      for (bool prefetch : {false, true}) {
+        auto stream =
+            binsparse::stream_nonzeros<T, I>(binsparse_file, 100, prefetch);
+        EXPECT_EQ(stream.m(), num_rows);
+        EXPECT_EQ(stream.n(), num_columns);
+        EXPECT_EQ(stream.nnz(), matrix.nnz);
+
+        // Batches are rounded up to whole chunks.
+        std::size_t offset = 0;
+        for (auto&& batch : stream) {
+          EXPECT_TRUE(batch.size() == 128 ||
+                      offset + batch.size() == matrix.nnz);
+          for (std::size_t k = 0; k < batch.size(); k++) {
+            EXPECT_EQ(batch.rowind[k], rowind[offset + k]);
+            EXPECT_EQ(batch.colind[k], matrix.colind[offset + k]);
+            EXPECT_EQ(batch.values[k], matrix.values[offset + k]);
+          }
+          offset += batch.size();
+        }
+        EXPECT_EQ(offset, matrix.nnz);
+      }
+    }
+  }
+}
+
+TEST(BinsparseReadWrite, RangeWriters) {
+  using T = float;
+  using I = std::size_t;
+
+  std::string binsparse_file = "out.bsp.hdf5";
+
+  binsparse::write_options options;
+  options.chunk_elements = 100;
+
+  auto x = binsparse::__detail::mmread<
+      T, I, binsparse::__detail::csr_matrix_owning<T, I>>(file_paths[0]);
+  auto&& [num_rows, num_columns] = x.shape();
+
+  std::vector<std::tuple<I, I, T>> tuples;
+  for (I i = 0; i < num_rows; i++) {
+    for (I k = x.rowptr()[i]; k < x.rowptr()[i + 1]; k++) {
+      tuples.push_back({i, x.colind()[k], x.values()[k]});
+    }
+  }
+
+  auto expect_equal = [&](auto&& matrix_) {
+    EXPECT_EQ(matrix_.m, num_rows);
+    EXPECT_EQ(matrix_.n, num_columns);
+    EXPECT_EQ(matrix_.nnz, tuples.size());
+  };
+
+  // A sized range of tuples, and a generator of unknown length.
+  auto generated = std::views::iota(std::size_t(0), tuples.size()) |
+                   std::views::filter([](auto) { return true; }) |
+                   std::views::transform([&](auto k) { return tuples[k]; });
+  static_assert(!std::ranges::sized_range<decltype(generated)>);
+
+  for (int sized = 0; sized < 2; sized++) {
+    if (sized) {
+      binsparse::write_csr_matrix(binsparse_file, tuples, num_rows,
+                                  num_columns, {}, options);
+    } else {
+      binsparse::write_csr_matrix(binsparse_file, generated, num_rows,
+                                  num_columns, {}, options);
+    }
+
+    auto matrix_ = binsparse::read_csr_matrix<T, I>(binsparse_file);
+    expect_equal(matrix_);
+    for (I i = 0; i < num_rows + 1; i++) {
+      EXPECT_EQ(matrix_.row_ptr[i], x.rowptr()[i]);
+    }
+    for (I k = 0; k < matrix_.nnz; k++) {
+      EXPECT_EQ(matrix_.colind[k], x.colind()[k]);
+      EXPECT_EQ(matrix_.values[k], x.values()[k]);
+    }
+
+    delete matrix_.values;
+    delete matrix_.row_ptr;
+    delete matrix_.colind;
+  }
+
+  // An array of structures, through projections.
+  struct edge {
+    int source;
+    int target;
+    double weight;
+  };
+
+  std::vector<edge> edges;
+  for (auto&& [i, j, v] : tuples) {
+    edges.push_back({int(i), int(j), v});
+  }
+
+  binsparse::write_coo_matrix(binsparse_file, edges, num_rows, num_columns, {},
+                              options, &edge::source, &edge::target,
+                              &edge::weight);
+
+  auto coo = binsparse::read_coo_matrix<double, I>(binsparse_file);
+  expect_equal(coo);
+  for (I k = 0; k < coo.nnz; k++) {
+    EXPECT_EQ(coo.rowind[k], std::get<0>(tuples[k]));
+    EXPECT_EQ(coo.colind[k], std::get<1>(tuples[k]));
+    EXPECT_EQ(coo.values[k], std::get<2>(tuples[k]));
+  }
+
+  delete coo.values;
+  delete coo.rowind;
+  delete coo.colind;
+
+  // CSR entries must be sorted by row.
+  std::swap(tuples.front(), tuples.back());
+  auto write_unsorted = [&] {
+    binsparse::write_csr_matrix(binsparse_file, tuples, num_rows,
+                                num_columns);
+  };
+  EXPECT_THROW(write_unsorted(), std::invalid_argument);
+
+  // Indices must lie within the shape.
+  std::swap(tuples.front(), tuples.back());
+  I max_row = 0;
+  I max_col = 0;
+  for (auto&& [i, j, v] : tuples) {
+    max_row = std::max(max_row, i);
+    max_col = std::max(max_col, j);
+  }
+  EXPECT_THROW(
+      binsparse::write_csr_matrix(binsparse_file, tuples, num_rows, max_col),
+      std::out_of_range);
+  EXPECT_THROW(binsparse::write_coo_matrix(binsparse_file, tuples, max_row,
+                                           num_columns),
+               std::out_of_range);
+  EXPECT_THROW(
+      binsparse::write_coo_matrix(binsparse_file, tuples, num_rows, max_col),
+      std::out_of_range);
+}
+
+TEST(BinsparseReadWrite, CSRReadInto) {
+  using T = float;
+  using I = std::size_t;
+
+  std::vector<T> values;
+  std::vector<I> colind;
+  std::vector<I> row_ptr;
+
+  // Load the largest matrix first, so later loads fit in the same storage.
+  std::vector<std::string> files;
+  for (auto&& file_path : file_paths) {
+    auto x = binsparse::__detail::mmread<
+        T, I, binsparse::__detail::csr_matrix_owning<T, I>>(file_path);
+    auto&& [num_rows, num_columns] = x.shape();
+    binsparse::csr_matrix<T, I> matrix{x.values().data(), x.colind().data(),
+                                       x.rowptr().data(), num_rows,
+                                       num_columns,       I(x.size())};
+    files.push_back("out" + std::to_string(files.size()) + ".bsp.hdf5");
+    binsparse::write_csr_matrix(files.back(), matrix);
+  }
+  std::ranges::sort(files, std::greater{}, [](const std::string& file) {
+    std::size_t nnz = binsparse::inspect(file)["binsparse"]["nnz"];
+    return nnz;
+  });
+
+  const T* values_data = nullptr;
+
+  for (std::size_t pass = 0; pass < 2; pass++) {
+    for (auto&& file : files) {
+      auto matrix_ = binsparse::read_csr_matrix_into(file, values, colind,
+                                                     row_ptr);
+      if (values_data == nullptr) {
+        values_data = values.data();
+      }
+      EXPECT_EQ(values.data(), values_data);
+
+      auto expected = binsparse::read_csr_matrix<T, I>(file);
+      EXPECT_EQ(matrix_.m, expected.m);
+      EXPECT_EQ(matrix_.n, expected.n);
+      EXPECT_EQ(matrix_.nnz, expected.nnz);
+      EXPECT_EQ(values.size(), expected.nnz);
+      for (I k = 0; k < expected.nnz; k++) {
+        EXPECT_EQ(matrix_.values[k], expected.values[k]);
+        EXPECT_EQ(matrix_.colind[k], expected.colind[k]);
+      }
+      for (I i = 0; i < expected.m + 1; i++) {
+        EXPECT_EQ(matrix_.row_ptr[i], expected.row_ptr[i]);
+      }
+
+      delete expected.values;
+      delete expected.row_ptr;
+      delete expected.colind;
+    }
+  }
+}
+
+TEST(BinsparseReadWrite, CSRValuesOnly) {
+  using T = float;
+  using I = std::size_t;
+
+  std::string binsparse_file = "out.bsp.hdf5";
+
+  for (auto&& file_path : file_paths) {
+    auto x = binsparse::__detail::mmread<
+        T, I, binsparse::__detail::csr_matrix_owning<T, I>>(file_path);
+    auto&& [num_rows, num_columns] = x.shape();
+    binsparse::csr_matrix<T, I> matrix{x.values().data(), x.colind().data(),
+                                       x.rowptr().data(), num_rows,
+                                       num_columns,       I(x.size())};
+    binsparse::write_csr_matrix(binsparse_file, matrix);
+
+    auto matrix_ = binsparse::read_csr_matrix<T, I>(binsparse_file);
+
+    for (std::size_t iteration = 1; iteration < 3; iteration++) {
+      for (auto&& v : x.values()) {
+        v += 1;
+      }
+      binsparse::update_values(binsparse_file, matrix);
+
+      if (iteration == 1) {
+        binsparse::read_values_into(binsparse_file, matrix_);
+      } else {
+        binsparse::reader r(binsparse_file);
+        r.read_values_into(matrix_);
+      }
+
+      for (I k = 0; k < matrix.nnz; k++) {
+        EXPECT_EQ(matrix_.values[k], matrix.values[k]);
+        EXPECT_EQ(matrix_.colind[k], matrix.colind[k]);
+      }
+    }
+
+    // The stored structure must match.
+    auto smaller = matrix;
+    smaller.nnz--;
+    EXPECT_THROW(binsparse::update_values(binsparse_file, smaller),
+                 std::invalid_argument);
+
+    binsparse::csc_matrix<T, I> transposed{matrix.values, matrix.colind,
+                                           matrix.row_ptr, num_columns,
+                                           num_rows,       matrix.nnz};
+    EXPECT_THROW(binsparse::read_values_into(binsparse_file, transposed),
+                 std::invalid_argument);
+
+    delete matrix_.values;
+    delete matrix_.row_ptr;
+    delete matrix_.colind;
+  }
+}
+
+TEST(BinsparseReadWrite, CSRNarrowIndices) {
+  using T = float;
+  using I = std::size_t;
+
+  std::string binsparse_file = "out.bsp.hdf5";
+
+  auto x = binsparse::__detail::mmread<
+      T, I, binsparse::__detail::csr_matrix_owning<T, I>>(file_paths[0]);
+  auto&& [num_rows, num_columns] = x.shape();
+  binsparse::csr_matrix<T, I> matrix{x.values().data(), x.colind().data(),
+                                     x.rowptr().data(), num_rows,
+                                     num_columns,       I(x.size())};
+
+  // 1138_bus has 1138 rows and columns and 4054 stored values, so both index
+  // arrays fit in 16 bits.  Uncompressed files keep the caller's type.
+  for (auto&& [options, index_type] :
+       {std::pair{binsparse::write_options{}, "uint16"},
+        std::pair{binsparse::write_options::uncompressed(), "uint64"}}) {
+    binsparse::write_csr_matrix(binsparse_file, matrix, {}, options);
+
+    auto metadata = binsparse::inspect(binsparse_file)["binsparse"];
+    EXPECT_EQ(metadata["data_types"]["indices_1"], index_type);
+    EXPECT_EQ(metadata["data_types"]["pointers_to_1"], index_type);
+
+    auto matrix_ = binsparse::read_csr_matrix<T, I>(binsparse_file);
+    for (I k = 0; k < matrix.nnz; k++) {
+      EXPECT_EQ(matrix_.colind[k], matrix.colind[k]);
+      EXPECT_EQ(matrix_.values[k], matrix.values[k]);
+    }
+    for (I i = 0; i < matrix.m + 1; i++) {
+      EXPECT_EQ(matrix_.row_ptr[i], matrix.row_ptr[i]);
+    }
+
+    // Partial reads widen only the elements read.
+    auto rows = binsparse::read_csr_rows<T, I>(binsparse_file, 100, 200);
+    for (I k = 0; k < rows.nnz; k++) {
+      EXPECT_EQ(rows.colind[k], matrix.colind[matrix.row_ptr[100] + k]);
+    }
+
+    delete matrix_.values;
+    delete matrix_.row_ptr;
+    delete matrix_.colind;
+    delete rows.values;
+    delete rows.row_ptr;
+    delete rows.colind;
+  }
+}
+
+TEST(BinsparseReadWrite, CSRPointerType) {
+  using T = float;
+  using I = std::uint32_t;
+  using P = std::uint64_t;
+
+  std::string binsparse_file = "out.bsp.hdf5";
+
+  for (auto&& file_path : file_paths) {
+    auto x = binsparse::__detail::mmread<
+        T, std::size_t, binsparse::__detail::csr_matrix_owning<T, std::size_t>>(
+        file_path);
+    auto&& [num_rows, num_columns] = x.shape();
+
+    std::vector<I> colind(x.colind().begin(), x.colind().end());
+    std::vector<P> row_ptr(x.rowptr().begin(), x.rowptr().end());
+    binsparse::csr_matrix<T, I, P> matrix{
+        x.values().data(), colind.data(), row_ptr.data(), I(num_rows),
+        I(num_columns),    P(x.size())};
+
+    binsparse::write_csr_matrix(binsparse_file, matrix, {},
+                                binsparse::write_options::uncompressed());
+
+    auto metadata = binsparse::inspect(binsparse_file)["binsparse"];
+    EXPECT_EQ(metadata["data_types"]["pointers_to_1"], "uint64");
+    EXPECT_EQ(metadata["data_types"]["indices_1"], "uint32");
+
+    std::vector<std::string> labels{metadata["data_types"]["pointers_to_1"],
+                                    metadata["data_types"]["indices_1"],
+                                    metadata["data_types"]["values"]};
+    bool visited = false;
+    binsparse::visit_label(labels, [&]<typename P_, typename I_, typename T_>(
+                                       P_, I_, T_) {
+      EXPECT_TRUE((std::is_same_v<P_, P>));
+      EXPECT_TRUE((std::is_same_v<I_, I>));
+      EXPECT_TRUE((std::is_same_v<T_, T>));
+
+      // HDF5 has no native type to read bool values as.
+      if constexpr (!std::is_same_v<T_, bool>) {
+        auto matrix_ = binsparse::read_csr_matrix<T_, I_, P_>(binsparse_file);
+        EXPECT_EQ(matrix.m, matrix_.m);
+        EXPECT_EQ(matrix.n, matrix_.n);
+        EXPECT_EQ(matrix.nnz, matrix_.nnz);
+        for (P k = 0; k < matrix.nnz; k++) {
+          EXPECT_EQ(matrix.colind[k], matrix_.colind[k]);
+          EXPECT_EQ(matrix.values[k], matrix_.values[k]);
+        }
+        for (I i = 0; i < matrix.m + 1; i++) {
+          EXPECT_EQ(matrix.row_ptr[i], matrix_.row_ptr[i]);
+        }
+
+        delete matrix_.values;
+        delete matrix_.row_ptr;
+        delete matrix_.colind;
+        visited = true;
+      }
+    });
+    EXPECT_TRUE(visited);
+  }
+}
+
+TEST(BinsparseReadWrite, AnyMatrix) {
+  using T = float;
+  using I = std::size_t;
+
+  std::string binsparse_file = "out.bsp.hdf5";
+
+  auto x = binsparse::__detail::mmread<
+      T, I, binsparse::__detail::csr_matrix_owning<T, I>>(file_paths[0]);
+  auto&& [num_rows, num_columns] = x.shape();
+  binsparse::csr_matrix<T, I> matrix{x.values().data(), x.colind().data(),
+                                     x.rowptr().data(), num_rows,
+                                     num_columns,       I(x.size())};
+
+  binsparse::write_csr_matrix(binsparse_file, matrix);
+
+  for (auto&& any : {binsparse::read_matrix(binsparse_file),
+                     binsparse::reader(binsparse_file).read_matrix()}) {
+    EXPECT_EQ(any.format(), binsparse::matrix_format::csr);
+    EXPECT_EQ(any.values_type(), binsparse::value_type::float32);
+    EXPECT_EQ(any.indices_type(), binsparse::index_type::uint32);
+    EXPECT_EQ(any.pointers_type(), binsparse::index_type::uint32);
+    EXPECT_EQ(any.m(), matrix.m);
+    EXPECT_EQ(any.n(), matrix.n);
+    EXPECT_EQ(any.nnz(), matrix.nnz);
+
+    using expected_type =
+        binsparse::csr_matrix<T, std::uint32_t, std::uint32_t>;
+
+    std::size_t visited = any.visit([&](auto&& m) -> std::size_t {
+      if constexpr (std::is_same_v<std::remove_cvref_t<decltype(m)>,
+                                   expected_type>) {
+        for (I k = 0; k < matrix.nnz; k++) {
+          EXPECT_EQ(m.colind[k], matrix.colind[k]);
+          EXPECT_EQ(m.values[k], matrix.values[k]);
+        }
+        for (I i = 0; i < matrix.m + 1; i++) {
+          EXPECT_EQ(m.row_ptr[i], matrix.row_ptr[i]);
+        }
+        return m.nnz;
+      } else {
+        return 0;
+      }
+    });
+    EXPECT_EQ(visited, matrix.nnz);
+  }
+
+  std::vector<double> v = {1.5, -2.0, 3.25};
+  {
+    H5::H5File f(binsparse_file.c_str(), H5F_ACC_TRUNC);
+    binsparse::write_dense_vector(f, std::span(v));
+  }
+
+  auto any = binsparse::read_matrix(binsparse_file);
+  EXPECT_EQ(any.format(), binsparse::matrix_format::dvec);
+  EXPECT_EQ(any.values_type(), binsparse::value_type::float64);
+
+  bool visited = any.visit([&](auto&& m) {
+    if constexpr (std::is_same_v<std::remove_cvref_t<decltype(m)>,
+                                 std::span<double>>) {
+      return std::equal(m.begin(), m.end(), v.begin(), v.end());
+    } else {
+      return false;
+    }
+  });
+  EXPECT_TRUE(visited);
+}
+
+TEST(BinsparseReadWrite, DCSRFormat) {
+  using T = float;
+  using I = std::size_t;
+
+  std::string binsparse_file = "out.bsp.hdf5";
+
+  auto x = binsparse::__detail::mmread<
+      T, I, binsparse::__detail::csr_matrix_owning<T, I>>(file_paths[0]);
+  auto&& [num_rows, num_columns] = x.shape();
+
+  // Spread the rows of 1138_bus out, so that at most one row in 1000 is
+  // nonempty.
+  I spacing = 1000;
+  I m = num_rows * spacing;
+  std::vector<I> row_ptr(m + 1);
+  for (I i = 0; i <= m; i++) {
+    row_ptr[i] = x.rowptr()[(i + spacing - 1) / spacing];
+  }
+
+  binsparse::csr_matrix<T, I> matrix{x.values().data(), x.colind().data(),
+                                     row_ptr.data(),    m,
+                                     num_columns,       I(x.size())};
+
+  for (std::size_t num_threads : {1, 3}) {
+    auto dcsr = binsparse::csr_to_dcsr(matrix, std::allocator<T>{},
+                                       num_threads);
+    EXPECT_EQ(dcsr.values, matrix.values);
+    I stored_rows = 0;
+    for (I r = 0; r < num_rows; r++) {
+      if (x.rowptr()[r + 1] != x.rowptr()[r]) {
+        EXPECT_EQ(dcsr.rowind[stored_rows], r * spacing);
+        EXPECT_EQ(dcsr.row_ptr[stored_rows], x.rowptr()[r]);
+        stored_rows++;
+      }
+    }
+    EXPECT_EQ(dcsr.stored_rows, stored_rows);
+    EXPECT_EQ(dcsr.row_ptr[dcsr.stored_rows], matrix.nnz);
+
+    binsparse::write_dcsr_matrix(binsparse_file, dcsr);
+    auto metadata = binsparse::inspect(binsparse_file)["binsparse"];
+    EXPECT_EQ(metadata["format"], "DCSR");
+
+    auto dcsr_ = binsparse::read_dcsr_matrix<T, I>(binsparse_file);
+    EXPECT_EQ(dcsr_.m, m);
+    EXPECT_EQ(dcsr_.n, matrix.n);
+    EXPECT_EQ(dcsr_.nnz, matrix.nnz);
+    EXPECT_EQ(dcsr_.stored_rows, dcsr.stored_rows);
+
+    auto csr = binsparse::dcsr_to_csr(dcsr_, std::allocator<T>{},
+                                      num_threads);
+    for (I i = 0; i <= m; i++) {
+      EXPECT_EQ(csr.row_ptr[i], matrix.row_ptr[i]);
+    }
+    for (I k = 0; k < matrix.nnz; k++) {
+      EXPECT_EQ(csr.colind[k], matrix.colind[k]);
+      EXPECT_EQ(csr.values[k], matrix.values[k]);
+    }
+
+    auto any = binsparse::read_matrix(binsparse_file);
+    EXPECT_EQ(any.format(), binsparse::matrix_format::dcsr);
+    std::size_t visited = any.visit([](auto&& m) -> std::size_t {
+      if constexpr (requires { m.stored_rows; }) {
+        return m.stored_rows;
+      } else {
+        return 0;
+      }
+    });
+    EXPECT_EQ(visited, stored_rows);
+
+    // The transpose of the matrix, stored by column.
+    binsparse::csc_matrix<T, I> transpose{matrix.values, matrix.colind,
+                                          matrix.row_ptr, matrix.n,
+                                          matrix.m,       matrix.nnz};
+    auto dcsc = binsparse::csc_to_dcsc(transpose, std::allocator<T>{},
+                                       num_threads);
+    binsparse::write_dcsc_matrix(binsparse_file, dcsc);
+    auto dcsc_ = binsparse::read_dcsc_matrix<T, I>(binsparse_file);
+    auto csc = binsparse::dcsc_to_csc(dcsc_, std::allocator<T>{},
+                                      num_threads);
+    for (I j = 0; j <= m; j++) {
+      EXPECT_EQ(csc.col_ptr[j], matrix.row_ptr[j]);
+    }
+
+    delete dcsr.rowind;
+    delete dcsr.row_ptr;
+    delete dcsr_.values;
+    delete dcsr_.colind;
+    delete dcsr_.row_ptr;
+    delete dcsr_.rowind;
+    delete csr.row_ptr;
+    delete dcsc.colind;
+    delete dcsc.col_ptr;
+    delete dcsc_.values;
+    delete dcsc_.rowind;
+    delete dcsc_.col_ptr;
+    delete dcsc_.colind;
+    delete csc.col_ptr;
+  }
+}
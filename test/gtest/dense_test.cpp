@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <filesystem>
+
+#include <binsparse/binsparse.hpp>
+
+TEST(BinsparseReadWrite, ChunkSizeLimit) {
+  binsparse::write_options options;
+  options.chunk_bytes = std::size_t(1) << 40;
+
+  EXPECT_LE(options.chunk_size<double>(hsize_t(1) << 40) * sizeof(double),
+            hdf5_tools::max_chunk_bytes);
+
+  options.chunk_elements = hsize_t(1) << 40;
+
+  EXPECT_LE(options.chunk_size<std::uint8_t>(hsize_t(1) << 40),
+            hdf5_tools::max_chunk_bytes);
+  EXPECT_EQ(options.chunk_size<std::uint8_t>(1000), 1000);
+}
+
+// Round-trips a dense matrix whose values dataset is larger than the largest
+// possible HDF5 chunk.  This needs about 5 GB of memory and disk, so it only
+// runs when `BINSPARSE_LARGE_TESTS` is set.
+TEST(BinsparseReadWrite, LargeDataset) {
+  if (std::getenv("BINSPARSE_LARGE_TESTS") == nullptr) {
+    GTEST_SKIP() << "set BINSPARSE_LARGE_TESTS to run";
+  }
+
+  using T = std::uint8_t;
+  using I = std::size_t;
+
+  std::string binsparse_file = "large.bsp.hdf5";
+
+  I m = 65537;
+  I n = 65537;
+  ASSERT_GT(m * n * sizeof(T), std::size_t(1) << 32);
+
+  auto pattern = [](std::size_t i) { return T((i * 2654435761u) >> 24); };
+
+  // Compression is disabled only to keep the test fast.
+  binsparse::write_options options;
+  options.deflate_level = 0;
+  options.shuffle = false;
+
+  {
+    std::vector<T> values(m * n);
+    for (std::size_t i = 0; i < values.size(); i++) {
+      values[i] = pattern(i);
+    }
+
+    binsparse::dense_matrix<T, I> matrix{values.data(), m, n};
+    binsparse::write_dense_matrix(binsparse_file, matrix, {}, options);
+  }
+
+  std::allocator<T> alloc;
+  auto matrix_ = binsparse::read_dense_matrix<T, I, binsparse::row_major>(
+      binsparse_file, alloc);
+
+  EXPECT_EQ(matrix_.m, m);
+  EXPECT_EQ(matrix_.n, n);
+
+  std::size_t mismatches = 0;
+  for (std::size_t i = 0; i < m * n; i++) {
+    mismatches += matrix_.values[i] != pattern(i);
+  }
+  EXPECT_EQ(mismatches, 0);
+
+  alloc.deallocate(matrix_.values, m * n);
+  std::filesystem::remove(binsparse_file);
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include <numeric>
+
+#include <binsparse/hdf5_tools.hpp>
+
+TEST(Hdf5Tools, ChunkedRangeReads) {
+  std::string file_name = "chunks.hdf5";
+
+  std::vector<std::uint64_t> data(10007);
+  for (std::size_t i = 0; i < data.size(); i++) {
+    data[i] = i * 2654435761u;
+  }
+
+  hdf5_tools::write_options shuffled;
+  shuffled.chunk_elements = 1000;
+  shuffled.deflate_level = 0;
+
+  hdf5_tools::write_options deflated;
+  deflated.chunk_elements = 1000;
+  deflated.shuffle = false;
+
+  hdf5_tools::write_options both;
+  both.chunk_elements = 1000;
+
+  for (auto options : {shuffled, deflated, both}) {
+    for (std::size_t num_threads : {1, 3}) {
+      {
+        H5::H5File f(file_name.c_str(), H5F_ACC_TRUNC);
+        options.num_threads = num_threads;
+        hdf5_tools::write_dataset(f, "data", data, options);
+      }
+
+      H5::H5File f(file_name.c_str(), H5F_ACC_RDONLY);
+      auto dataset = f.openDataSet("data");
+
+      // Chunks written directly must decode through HDF5's own pipeline.
+      std::vector<std::uint64_t> pipeline(data.size());
+      dataset.read(pipeline.data(), H5::PredType::NATIVE_UINT64);
+      EXPECT_EQ(pipeline, data);
+
+      std::vector<std::pair<std::size_t, std::size_t>> ranges = {
+          {0, data.size()}, {0, 1000}, {1500, 10}, {999, 1002}, {9990, 17}};
+
+      for (auto&& [offset, count] : ranges) {
+        std::vector<std::uint64_t> out(count);
+        hdf5_tools::read_dataset(dataset, offset, count, out.data(),
+                                 num_threads);
+        EXPECT_TRUE(std::equal(out.begin(), out.end(), data.begin() + offset));
+      }
+    }
+  }
+}
+
+TEST(Hdf5Tools, ConvertedReads) {
+  std::string file_name = "converted.hdf5";
+
+  std::vector<std::uint16_t> small(10007);
+  for (std::size_t i = 0; i < small.size(); i++) {
+    small[i] = (i * 40503u) % 65536;
+  }
+  std::vector<std::int64_t> negative = {-5, 0, 7, -100000};
+  std::vector<double> fractional = {1.0, 2.5, -3.0};
+  std::vector<std::int8_t> bytes_signed = {-128, -1, 0, 1, 127};
+
+  hdf5_tools::write_options options;
+  options.chunk_elements = 1000;
+
+  {
+    H5::H5File f(file_name.c_str(), H5F_ACC_TRUNC);
+    hdf5_tools::write_dataset(f, "small", small, options);
+    hdf5_tools::write_dataset(f, "negative", negative, options);
+    hdf5_tools::write_dataset(f, "fractional", fractional, options);
+    // Contiguous datasets are read through HDF5 rather than chunk by chunk.
+    hdf5_tools::write_dataset(f, "bytes_signed", bytes_signed,
+                              hdf5_tools::write_options::uncompressed());
+  }
+
+  H5::H5File f(file_name.c_str(), H5F_ACC_RDONLY);
+
+  EXPECT_TRUE(hdf5_tools::dataset_type(f, "small") ==
+              H5::PredType::STD_U16LE);
+  EXPECT_TRUE(hdf5_tools::dataset_type(f, "negative") ==
+              H5::PredType::STD_I64LE);
+
+  auto check_small = [&]<typename T>(T) {
+    auto dataset = f.openDataSet("small");
+    std::vector<std::pair<std::size_t, std::size_t>> ranges = {
+        {0, small.size()}, {1500, 10}, {999, 1002}, {9990, 17}};
+    for (auto&& [offset, count] : ranges) {
+      std::vector<T> out(count);
+      hdf5_tools::read_dataset(dataset, offset, count, out.data());
+      for (std::size_t k = 0; k < count; k++) {
+        EXPECT_EQ(out[k], T(small[offset + k]));
+      }
+    }
+  };
+  check_small(std::uint32_t());
+  check_small(std::int32_t());
+  check_small(std::uint64_t());
+  check_small(double());
+
+  // Values are range-checked when they are narrowed.
+  std::vector<std::uint8_t> bytes;
+  EXPECT_THROW(hdf5_tools::read_dataset_into(f, "small", bytes),
+               std::out_of_range);
+  std::vector<std::int16_t> shorts;
+  EXPECT_THROW(hdf5_tools::read_dataset_into(f, "small", shorts),
+               std::out_of_range);
+
+  std::vector<std::int32_t> ints;
+  hdf5_tools::read_dataset_into(f, "negative", ints);
+  EXPECT_TRUE(std::equal(ints.begin(), ints.end(), negative.begin()));
+  std::vector<std::uint32_t> unsigned_ints;
+  EXPECT_THROW(hdf5_tools::read_dataset_into(f, "negative", unsigned_ints),
+               std::out_of_range);
+
+  hdf5_tools::read_dataset_into(f, "bytes_signed", ints);
+  EXPECT_TRUE(std::equal(ints.begin(), ints.end(), bytes_signed.begin(),
+                         bytes_signed.end()));
+  std::vector<std::int8_t> bytes_signed_;
+  hdf5_tools::read_dataset_into(f, "bytes_signed", bytes_signed_);
+  EXPECT_EQ(bytes_signed_, bytes_signed);
+  EXPECT_THROW(hdf5_tools::read_dataset_into(f, "bytes_signed", unsigned_ints),
+               std::out_of_range);
+
+  std::vector<float> floats;
+  hdf5_tools::read_dataset_into(f, "fractional", floats);
+  EXPECT_TRUE(std::equal(floats.begin(), floats.end(), fractional.begin()));
+  EXPECT_THROW(hdf5_tools::read_dataset_into(f, "fractional", ints),
+               std::out_of_range);
+}
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+
+#include <fmt/core.h>
+
+#include <binsparse/binsparse.hpp>
+#include <binsparse/matrix_market/matrix_market_convert.hpp>
+#include <fstream>
+#include <random>
+
+namespace {
+
+// Write a synthetic Matrix Market file large enough to be split across
+// several parsing threads.
+std::string write_synthetic_matrix_market(std::size_t m, std::size_t n,
+                                          std::size_t nnz) {
+  std::string file_path = "synthetic.mtx";
+  std::ofstream f(file_path);
+
+  f << "%%MatrixMarket matrix coordinate real general\n";
+  f << "% synthetic matrix\n";
+  f << m << " " << n << " " << nnz << "\n";
+
+  std::mt19937_64 gen(1234);
+  std::uniform_int_distribution<std::size_t> row(1, m);
+  std::uniform_int_distribution<std::size_t> col(1, n);
+  std::uniform_real_distribution<double> value(-100, 100);
+
+  for (std::size_t k = 0; k < nnz; k++) {
+    if (k % 1000 == 0) {
+      f << "% interleaved comment\n\n";
+    }
+    f << row(gen) << " " << col(gen) << " " << value(gen) << "\n";
+  }
+
+  return file_path;
+}
+
+} // namespace
+
+TEST(MatrixMarket, ParallelParse) {
+  using T = double;
+  using I = std::size_t;
+
+  std::size_t m = 100000;
+  std::size_t n = 50000;
+  std::size_t nnz = 400000;
+
+  auto file_path = write_synthetic_matrix_market(m, n, nnz);
+
+  using matrix_type = binsparse::__detail::coo_matrix_owning<T, I>;
+
+  auto serial =
+      binsparse::__detail::mmread<T, I, matrix_type>(file_path, true, 1);
+  auto parallel =
+      binsparse::__detail::mmread<T, I, matrix_type>(file_path, true, 8);
+
+  EXPECT_EQ(serial.size(), nnz);
+  EXPECT_EQ(serial.size(), parallel.size());
+  EXPECT_EQ(serial.shape(), parallel.shape());
+
+  EXPECT_TRUE(std::ranges::equal(serial.rowind(), parallel.rowind()));
+  EXPECT_TRUE(std::ranges::equal(serial.colind(), parallel.colind()));
+  EXPECT_TRUE(std::ranges::equal(serial.values(), parallel.values()));
+}
+
+TEST(MatrixMarket, ArrayAndMetadata) {
+  std::string file_path = "synthetic_array.mtx";
+
+  {
+    std::ofstream f(file_path);
+    f << "%%MatrixMarket matrix array real general\r\n";
+    f << "% synthetic vector\r\n";
+    f << "5 1\r\n";
+    for (int i = 0; i < 5; i++) {
+      f << 0.5 * i << "\r\n";
+    }
+  }
+
+  auto [m, n, nnz, format, type, structure, comment] =
+      binsparse::mmread_metadata(file_path);
+
+  EXPECT_EQ(m, 5);
+  EXPECT_EQ(n, 1);
+  EXPECT_EQ(nnz, 5);
+  EXPECT_EQ(format, "array");
+  EXPECT_EQ(type, "real");
+  EXPECT_EQ(structure, "general");
+
+  auto values = binsparse::__detail::mmread_array<float>(file_path);
+
+  ASSERT_EQ(values.size(), 5);
+  for (int i = 0; i < 5; i++) {
+    EXPECT_EQ(values[i], 0.5f * i);
+  }
+}
+
+TEST(MatrixMarket, ExternalSortConversion) {
+  using T = double;
+  using I = std::size_t;
+
+  std::size_t m = 100000;
+  std::size_t n = 50000;
+  std::size_t nnz = 400000;
+
+  auto file_path = write_synthetic_matrix_market(m, n, nnz);
+
+  // Small enough to force the conversion to spill many sorted runs.
+  std::size_t memory_budget = 1 << 20;
+
+  std::string binsparse_file = "external.bsp.hdf5";
+
+  auto coo = binsparse::__detail::mmread<
+      T, I, binsparse::__detail::coo_matrix_owning<T, I>>(file_path);
+  auto csr = binsparse::__detail::mmread<
+      T, I, binsparse::__detail::csr_matrix_owning<T, I>>(file_path);
+
+  {
+    H5::H5File f(binsparse_file.c_str(), H5F_ACC_TRUNC);
+    binsparse::convert_matrix_market<T, I>(file_path, f, "COO", memory_budget);
+  }
+
+  auto coo_ = binsparse::read_coo_matrix<T, I>(binsparse_file);
+
+  ASSERT_EQ(coo_.nnz, coo.size());
+  EXPECT_EQ(coo_.m, m);
+  EXPECT_EQ(coo_.n, n);
+  EXPECT_TRUE(std::ranges::equal(coo.rowind(),
+                                 std::span(coo_.rowind, coo_.nnz)));
+  EXPECT_TRUE(std::ranges::equal(coo.colind(),
+                                 std::span(coo_.colind, coo_.nnz)));
+  EXPECT_TRUE(std::ranges::equal(coo.values(),
+                                 std::span(coo_.values, coo_.nnz)));
+
+  delete coo_.values;
+  delete coo_.rowind;
+  delete coo_.colind;
+
+  {
+    H5::H5File f(binsparse_file.c_str(), H5F_ACC_TRUNC);
+    binsparse::convert_matrix_market<T, I>(file_path, f, "CSR", memory_budget);
+  }
+
+  auto csr_ = binsparse::read_csr_matrix<T, I>(binsparse_file);
+
+  ASSERT_EQ(csr_.nnz, csr.size());
+  EXPECT_TRUE(std::ranges::equal(csr.rowptr(),
+                                 std::span(csr_.row_ptr, csr_.m + 1)));
+  EXPECT_TRUE(std::ranges::equal(csr.colind(),
+                                 std::span(csr_.colind, csr_.nnz)));
+  EXPECT_TRUE(std::ranges::equal(csr.values(),
+                                 std::span(csr_.values, csr_.nnz)));
+
+  delete csr_.values;
+  delete csr_.row_ptr;
+  delete csr_.colind;
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <fmt/core.h>
+
+#include <binsparse/binsparse.hpp>
+#include <binsparse/radix_sort.hpp>
+#include <random>
+
+namespace {
+
+template <typename T, typename I>
+void check_sort_coo(std::size_t m, std::size_t n, std::size_t nnz,
+                    std::size_t num_threads) {
+  std::mt19937_64 gen(42);
+  std::uniform_int_distribution<std::size_t> row(0, m - 1);
+  std::uniform_int_distribution<std::size_t> col(0, n - 1);
+
+  std::vector<I> rowind(nnz);
+  std::vector<I> colind(nnz);
+  std::vector<T> values(nnz);
+
+  for (std::size_t k = 0; k < nnz; k++) {
+    rowind[k] = row(gen);
+    colind[k] = col(gen);
+    values[k] = T(k);
+  }
+
+  std::vector<std::tuple<I, I, T>> reference(nnz);
+  for (std::size_t k = 0; k < nnz; k++) {
+    reference[k] = {rowind[k], colind[k], values[k]};
+  }
+  std::ranges::stable_sort(reference, [](auto&& a, auto&& b) {
+    return std::tie(std::get<0>(a), std::get<1>(a)) <
+           std::tie(std::get<0>(b), std::get<1>(b));
+  });
+
+  binsparse::__detail::sort_coo(rowind, colind, values, m, n, num_threads);
+
+  for (std::size_t k = 0; k < nnz; k++) {
+    EXPECT_EQ(rowind[k], std::get<0>(reference[k]));
+    EXPECT_EQ(colind[k], std::get<1>(reference[k]));
+    EXPECT_EQ(values[k], std::get<2>(reference[k]));
+  }
+}
+
+} // namespace
+
+TEST(RadixSort, PackedKeys) {
+  check_sort_coo<float, std::uint32_t>(1000, 700, 300000, 4);
+  check_sort_coo<double, std::uint64_t>(std::size_t(1) << 30,
+                                        std::size_t(1) << 20, 300000, 4);
+}
+
+TEST(RadixSort, WideKeys) {
+  check_sort_coo<double, std::uint64_t>(std::size_t(1) << 40,
+                                        std::size_t(1) << 40, 300000, 4);
+}
+
+TEST(RadixSort, SingleRowOrColumn) {
+  check_sort_coo<float, std::uint32_t>(1, 5000, 10000, 2);
+  check_sort_coo<float, std::uint32_t>(5000, 1, 10000, 2);
+}
+
+TEST(CountingSort, CSRFromUnsortedTuples) {
+  using T = float;
+  using I = std::uint32_t;
+
+  std::size_t m = 2000;
+  std::size_t n = 3000;
+  std::size_t nnz = 500000;
+
+  std::mt19937_64 gen(7);
+  std::uniform_int_distribution<std::size_t> row(0, m - 1);
+  std::uniform_int_distribution<std::size_t> col(0, n - 1);
+
+  std::vector<I> rowind(nnz);
+  std::vector<I> colind(nnz);
+  std::vector<T> values(nnz);
+
+  for (std::size_t k = 0; k < nnz; k++) {
+    rowind[k] = row(gen);
+    colind[k] = col(gen);
+    values[k] = T(rowind[k]) * n + colind[k];
+  }
+
+  binsparse::__detail::csr_matrix_owning<T, I> expected({I(m), I(n)});
+  {
+    auto r = rowind;
+    auto c = colind;
+    auto v = values;
+    binsparse::__detail::sort_coo(r, c, v, m, n, 1);
+    expected.assign_arrays(std::move(r), std::move(c), std::move(v), 1);
+  }
+
+  binsparse::__detail::csr_matrix_owning<T, I> csr({I(m), I(n)});
+  csr.assign_unsorted(std::move(rowind), std::move(colind), std::move(values),
+                      4);
+
+  EXPECT_EQ(csr.size(), nnz);
+  EXPECT_TRUE(std::ranges::equal(csr.rowptr(), expected.rowptr()));
+  EXPECT_TRUE(std::ranges::equal(csr.colind(), expected.colind()));
+  EXPECT_TRUE(std::ranges::equal(csr.values(), expected.values()));
+}